@@ -35,9 +35,9 @@ restriction could be lifted)
 JSON object or a JSON array. JSON "float" quantities are actually
 stored as doubles.
 
-   This parser processes object arrays in one of two different ways,
-defending on whether the array subtype is declared as object or
-structobject.
+   This parser processes object arrays in one of three different ways,
+defending on whether the array subtype is declared as object,
+structobject or columnobject.
 
    Object arrays take one base address per object subfield, and are
 mapped into parallel C arrays (one per subfield).  Strings are not
@@ -52,6 +52,12 @@ If you initialize the offset fields with the correct offsetof calls,
 everything will work. Strings are supported but all string storage
 has to be inline in the struct.
 
+   Columnobject arrays are the transpose of structobject arrays.  The
+base address points at a struct whose members are arrays, and each
+subfield's offset names one of them; element i of the JSON array lands
+in row i of every column.  Strings are supported here, each column
+being a fixed-width store of len bytes per row.
+
 PERMISSIONS
    This file is Copyright (c) 2014 by Eric S. Raymond
    SPDX-License-Identifier: BSD-2-Clause
@@ -62,21 +68,86 @@ PERMISSIONS
  * newer features (like clock_gettime).  See the POSIX spec for more info:
  * http://pubs.opengroup.org/onlinepubs/9699919799/functions/V2_chap02.html#tag_15_02_01_02 */
 #define _XOPEN_SOURCE 600
+#ifdef JIT_ENABLE
+/* ...and MAP_ANONYMOUS for the template compiler is a BSD/GNU extension */
+#define _DEFAULT_SOURCE
+#endif
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
-#include <ctype.h>
 #include <errno.h>
 #include <time.h>
 #include <math.h>	/* for HUGE_VAL */
+#include <limits.h>
+#include <stddef.h>
 
 #include "mjson.h"
 
+#if defined(JIT_ENABLE) && defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define JSON_JIT_X86_64
+#define JSON_JIT_MAXATTRS	256	/* largest template compiled */
+#endif
+
 #define str_starts_with(s, p)	(strncmp(s, p, strlen(p)) == 0)
 
+/*
+ * Character classes, so the lexer does not depend on the locale-aware
+ * <ctype.h> functions or on setlocale().  Whitespace is exactly what
+ * isspace() accepts in the C locale.
+ */
+#define JSON_C_SPACE	0x01
+#define JSON_C_DIGIT	0x02
+#define JSON_C_XDIGIT	0x04
+#define JSON_C_ALNUM	0x08
+#define JSON_C_DELIM	0x10	/* ends an unquoted token */
+#define JSON_C_NUM	0x20	/* may appear in a number */
+#define JSON_C_FRAC	0x40	/* marks a number as real */
+
+#define JSON_C_WS	(JSON_C_SPACE | JSON_C_DELIM)
+#define JSON_C_DEC	(JSON_C_DIGIT | JSON_C_XDIGIT | JSON_C_ALNUM | JSON_C_NUM)
+#define JSON_C_HEX	(JSON_C_XDIGIT | JSON_C_ALNUM)
+#define JSON_C_EXP	(JSON_C_HEX | JSON_C_NUM | JSON_C_FRAC)
+
+static const unsigned char json_cclass[UCHAR_MAX + 1] = {
+    ['\0'] = JSON_C_DELIM, [','] = JSON_C_DELIM, ['}'] = JSON_C_DELIM,
+    ['\t'] = JSON_C_WS, ['\n'] = JSON_C_WS, ['\v'] = JSON_C_WS,
+    ['\f'] = JSON_C_WS, ['\r'] = JSON_C_WS, [' '] = JSON_C_WS,
+    ['+'] = JSON_C_NUM, ['-'] = JSON_C_NUM, ['.'] = JSON_C_NUM | JSON_C_FRAC,
+    ['0'] = JSON_C_DEC, ['1'] = JSON_C_DEC, ['2'] = JSON_C_DEC,
+    ['3'] = JSON_C_DEC, ['4'] = JSON_C_DEC, ['5'] = JSON_C_DEC,
+    ['6'] = JSON_C_DEC, ['7'] = JSON_C_DEC, ['8'] = JSON_C_DEC,
+    ['9'] = JSON_C_DEC,
+    ['A'] = JSON_C_HEX, ['B'] = JSON_C_HEX, ['C'] = JSON_C_HEX,
+    ['D'] = JSON_C_HEX, ['E'] = JSON_C_EXP, ['F'] = JSON_C_HEX,
+    ['a'] = JSON_C_HEX, ['b'] = JSON_C_HEX, ['c'] = JSON_C_HEX,
+    ['d'] = JSON_C_HEX, ['e'] = JSON_C_EXP, ['f'] = JSON_C_HEX,
+    ['G'] = JSON_C_ALNUM, ['H'] = JSON_C_ALNUM, ['I'] = JSON_C_ALNUM,
+    ['J'] = JSON_C_ALNUM, ['K'] = JSON_C_ALNUM, ['L'] = JSON_C_ALNUM,
+    ['M'] = JSON_C_ALNUM, ['N'] = JSON_C_ALNUM, ['O'] = JSON_C_ALNUM,
+    ['P'] = JSON_C_ALNUM, ['Q'] = JSON_C_ALNUM, ['R'] = JSON_C_ALNUM,
+    ['S'] = JSON_C_ALNUM, ['T'] = JSON_C_ALNUM, ['U'] = JSON_C_ALNUM,
+    ['V'] = JSON_C_ALNUM, ['W'] = JSON_C_ALNUM, ['X'] = JSON_C_ALNUM,
+    ['Y'] = JSON_C_ALNUM, ['Z'] = JSON_C_ALNUM,
+    ['g'] = JSON_C_ALNUM, ['h'] = JSON_C_ALNUM, ['i'] = JSON_C_ALNUM,
+    ['j'] = JSON_C_ALNUM, ['k'] = JSON_C_ALNUM, ['l'] = JSON_C_ALNUM,
+    ['m'] = JSON_C_ALNUM, ['n'] = JSON_C_ALNUM, ['o'] = JSON_C_ALNUM,
+    ['p'] = JSON_C_ALNUM, ['q'] = JSON_C_ALNUM, ['r'] = JSON_C_ALNUM,
+    ['s'] = JSON_C_ALNUM, ['t'] = JSON_C_ALNUM, ['u'] = JSON_C_ALNUM,
+    ['v'] = JSON_C_ALNUM, ['w'] = JSON_C_ALNUM, ['x'] = JSON_C_ALNUM,
+    ['y'] = JSON_C_ALNUM, ['z'] = JSON_C_ALNUM,
+};
+
+#define json_class(c)	(json_cclass[(unsigned char)(c)])
+#define json_isspace(c)	((json_class(c) & JSON_C_SPACE) != 0)
+#define json_isdigit(c)	((json_class(c) & JSON_C_DIGIT) != 0)
+#define json_isxdigit(c)	((json_class(c) & JSON_C_XDIGIT) != 0)
+#define json_isalnum(c)	((json_class(c) & JSON_C_ALNUM) != 0)
+#define json_isdelim(c)	((json_class(c) & JSON_C_DELIM) != 0)
+
 #ifdef DEBUG_ENABLE
 static int debuglevel = 0;
 static FILE *debugfp;
@@ -92,17 +163,13 @@ static void json_trace(int errlevel, const char *fmt, ...)
 /* assemble command in printf(3) style */
 {
     if (errlevel <= debuglevel) {
-	char buf[BUFSIZ];
 	va_list ap;
 
-	(void)strncpy(buf, "json: ", BUFSIZ-1);
-	buf[BUFSIZ-1] = '\0';
+	/* straight to the stream; a BUFSIZ buffer would dwarf the parser */
+	(void)fputs("json: ", debugfp);
 	va_start(ap, fmt);
-	(void)vsnprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), fmt,
-			ap);
+	(void)vfprintf(debugfp, fmt, ap);
 	va_end(ap);
-
-	(void)fputs(buf, debugfp);
     }
 }
 
@@ -111,12 +178,55 @@ static void json_trace(int errlevel, const char *fmt, ...)
 # define json_debug_trace(args) do { } while (0)
 #endif /* DEBUG_ENABLE */
 
+static size_t json_column_width(const struct json_attr_t *cursor)
+/* size of one element of a column in a t_columnobject array */
+{
+    switch (cursor->type) {
+    case t_integer:
+	return sizeof(int);
+    case t_uinteger:
+	return sizeof(unsigned int);
+    case t_short:
+	return sizeof(short);
+    case t_ushort:
+	return sizeof(unsigned short);
+    case t_time:
+    case t_real:
+	return sizeof(double);
+    case t_string:
+	return cursor->len;
+    case t_arenastring:
+	return sizeof(struct json_string_t);
+    case t_boolean:
+	return sizeof(bool);
+    case t_character:
+	return sizeof(char);
+    default:
+	/* t_bitset columns are indexed by bit, see json_target_bit() */
+	return 0;
+    }
+}
+
+static size_t json_member_offset(const struct json_attr_t *cursor)
+/* offset of a structure member; arena strings keep theirs beside the arena */
+{
+    return cursor->type == t_arenastring
+	? cursor->addr.astring.target.offset : cursor->addr.offset;
+}
+
 static char *json_target_address(const struct json_attr_t *cursor,
 					     const struct json_array_t
 					     *parent, int offset)
 {
     char *targetaddr = NULL;
-    if (parent == NULL || parent->element_type != t_structobject) {
+    if (parent != NULL && parent->element_type == t_columnobject) {
+	/* column case - the offset selects a column, the index a row */
+	if (cursor->type == t_ignore || cursor->type == t_check)
+	    targetaddr = NULL;
+	else
+	    targetaddr = parent->arr.objects.base + json_member_offset(cursor)
+		+ offset * json_column_width(cursor);
+    } else if (parent == NULL || parent->element_type != t_structobject) {
 	/* ordinary case - use the address in the cursor structure */
 	switch (cursor->type) {
 	case t_ignore:
@@ -141,12 +251,19 @@ static char *json_target_address(const struct json_attr_t *cursor,
 	case t_string:
 	    targetaddr = cursor->addr.string;
 	    break;
+	case t_arenastring:
+	    targetaddr = (char *)&cursor->addr.astring.target.store[offset];
+	    break;
 	case t_boolean:
 	    targetaddr = (char *)&cursor->addr.boolean[offset];
 	    break;
 	case t_character:
 	    targetaddr = (char *)&cursor->addr.character[offset];
 	    break;
+	case t_bitset:
+	    /* json_target_bit() says which bit of the array to touch */
+	    targetaddr = (char *)cursor->addr.bitset;
+	    break;
 	default:
 	    targetaddr = NULL;
 	    break;
@@ -155,12 +272,574 @@ static char *json_target_address(const struct json_attr_t *cursor,
 	/* tricky case - hacking a member in an array of structures */
 	targetaddr =
 	    parent->arr.objects.base + (offset * parent->arr.objects.stride) +
-	    cursor->addr.offset;
+	    json_member_offset(cursor);
     json_debug_trace((1, "Target address for %s (offset %d) is %p\n",
 		      cursor->attribute, offset, targetaddr));
     return targetaddr;
 }
 
+static size_t json_target_bit(const struct json_attr_t *cursor,
+			      const struct json_array_t *parent, int offset)
+/* bit number within the t_bitset words returned by json_target_address() */
+{
+    if (parent == NULL || parent->element_type != t_structobject)
+	return cursor->len + (size_t)offset;
+    else
+	return cursor->len;
+}
+
+static void json_bit_store(char *words, size_t bit, bool val)
+/* set or clear one bit in a uint64_t array of unknown alignment */
+{
+    uint64_t word, mask = (uint64_t)1 << (bit % 64);
+
+    words += (bit / 64) * sizeof(uint64_t);
+    memcpy(&word, words, sizeof(uint64_t));
+    if (val)
+	word |= mask;
+    else
+	word &= ~mask;
+    memcpy(words, &word, sizeof(uint64_t));
+}
+
+static void json_bit_truncate(char *word, size_t keep)
+/* clear all but the low keep bits of one uint64_t of unknown alignment */
+{
+    uint64_t w;
+
+    memcpy(&w, word, sizeof(uint64_t));
+    w &= ((uint64_t)1 << keep) - 1;
+    memcpy(word, &w, sizeof(uint64_t));
+}
+
+/*
+ * Store journal.  In commit-on-success mode every store a parse makes
+ * is appended to the caller's journal instead of being done, as a
+ * packed entry header followed by the bytes to copy.  Only when the
+ * whole parse succeeds are the entries replayed into the targets, in
+ * order.  The few values the parser must read back while it runs (an
+ * arena's fill level, an array count during an update) are written at
+ * once, and their old contents are kept in fixed-size undo records
+ * growing down from the end of the buffer, so a failed parse can put
+ * them back.
+ *
+ * A header is two varints: len << 4 | dead << 3 | op, then the
+ * target's distance from the first target journaled, zigzag coded.
+ * Targets are usually close together, so a header is two to four
+ * bytes.  A string is one jop_str entry: the field's size in len, then
+ * a varint count of the bytes that follow; the rest is zeroed.
+ *
+ * The defaults an object applies are all journaled before any of its
+ * values, and its frame remembers where.  A value stored at the same
+ * place as one of them overwrites the default's bytes in place when it
+ * has the same shape, and otherwise marks the default dead, so fields
+ * the input supplies cost one entry, not two.
+ */
+
+enum {jop_copy, jop_zero, jop_str, jop_bit, jop_trunc};
+
+#define JSON_JDEAD	0x08	/* in a header's first byte */
+
+struct json_jentry_t {
+    char *dst;
+    size_t len;		/* bytes at dst, or a bit number */
+    int op;
+    bool dead;
+    size_t ndata;	/* bytes of data following the header */
+    char *data;
+};
+
+struct json_jundo_t {
+    char *dst;
+    size_t len;
+    char old[sizeof(size_t)];
+};
+
+static size_t json_varint_len(uint64_t v)
+{
+    size_t n = 1;
+
+    for (; v >= 0x80; v >>= 7)
+	n++;
+    return n;
+}
+
+static size_t json_varint_put(char *p, uint64_t v)
+{
+    size_t n = 0;
+
+    for (; v >= 0x80; v >>= 7)
+	p[n++] = (char)(v | 0x80);
+    p[n++] = (char)v;
+    return n;
+}
+
+static uint64_t json_varint_get(char **pp)
+{
+    const unsigned char *p = (const unsigned char *)*pp;
+    uint64_t v = 0;
+    int shift = 0;
+
+    do {
+	v |= (uint64_t)(*p & 0x7f) << shift;
+	shift += 7;
+    } while (*p++ & 0x80);
+    *pp = (char *)p;
+    return v;
+}
+
+static uint64_t json_journal_where(struct json_journal_t *jn, char *dst)
+/* dst as a zigzag-coded distance from the journal's first target */
+{
+    uint64_t d;
+
+    if (jn->base == NULL)
+	jn->base = dst;
+    d = (uint64_t)((uintptr_t)dst - (uintptr_t)jn->base);
+    return (d << 1) ^ (uint64_t)-(int64_t)(d >> 63);
+}
+
+static size_t json_journal_decode(const struct json_journal_t *jn,
+				  size_t off, struct json_jentry_t *e)
+/* unpack the entry at off, returning the offset of the next one */
+{
+    char *p = jn->buf + off;
+    uint64_t h = json_varint_get(&p), z = json_varint_get(&p);
+    uint64_t d = (z >> 1) ^ (uint64_t)-(int64_t)(z & 1);
+
+    e->dst = (char *)((uintptr_t)jn->base + (uintptr_t)d);
+    e->len = (size_t)(h >> 4);
+    e->op = (int)(h & 0x07);
+    e->dead = (h & JSON_JDEAD) != 0;
+    if (e->op == jop_copy)
+	e->ndata = e->len;
+    else if (e->op == jop_str)
+	e->ndata = (size_t)json_varint_get(&p);
+    else if (e->op == jop_bit)
+	e->ndata = 1;
+    else
+	e->ndata = 0;
+    e->data = p;
+    return (size_t)(p - jn->buf) + e->ndata;
+}
+
+static char *json_journal_entry(struct json_journal_t *jn, int op,
+				char *dst, size_t len, size_t datalen)
+/* append an entry header, returning where its data goes, or NULL */
+{
+    uint64_t h = (uint64_t)len << 4 | (uint64_t)op;
+    uint64_t z = json_journal_where(jn, dst);
+    size_t hlen = json_varint_len(h) + json_varint_len(z);
+    char *hp = jn->buf + jn->used;
+
+    if (hlen + datalen > jn->size - jn->used - jn->undo) {
+	json_debug_trace((1, "Store journal full.\n"));
+	return NULL;
+    }
+    hp += json_varint_put(hp, h);
+    hp += json_varint_put(hp, z);
+    jn->used += hlen + datalen;
+    return hp;
+}
+
+static char *json_journal_reuse(struct json_journal_t *jn, int op,
+				char *dst, size_t len, size_t ndata)
+/*
+ * Look among the current object's defaults for one at dst that this
+ * store overwrites.  Return where to put the data if it can be
+ * overwritten in place; otherwise mark it dead and return NULL.
+ */
+{
+    struct json_jentry_t e;
+    size_t off, next;
+    bool wrapped = false;
+
+    if (jn->dflt == jn->dflt_end)
+	return NULL;
+    /* values mostly come in template order; start after the last hit */
+    for (off = jn->dflt_next;; off = next) {
+	if (off >= jn->dflt_end) {
+	    if (wrapped)
+		return NULL;
+	    wrapped = true;
+	    off = jn->dflt;
+	}
+	if (wrapped && off >= jn->dflt_next)
+	    return NULL;	/* all the way round */
+	next = json_journal_decode(jn, off, &e);
+	if (e.dead || e.dst != dst
+	    || (op == jop_bit) != (e.op == jop_bit)
+	    || (op == jop_bit ? e.len != len : e.len > len))
+	    continue;
+	jn->dflt_next = next;
+	if (e.op == op && e.len == len && e.ndata == ndata)
+	    return e.data;
+	jn->buf[off] |= JSON_JDEAD;
+	return NULL;
+    }
+}
+
+static int json_put(struct json_journal_t *jn, void *dst, const void *src,
+		    size_t len)
+/* store len bytes at dst, now or on commit */
+{
+    char *dp;
+
+    if (jn == NULL) {
+	memcpy(dst, src, len);
+	return 0;
+    }
+    dp = json_journal_reuse(jn, jop_copy, dst, len, len);
+    if (dp == NULL
+	&& (dp = json_journal_entry(jn, jop_copy, dst, len, len)) == NULL)
+	return JSON_ERR_JOURNALFULL;
+    memcpy(dp, src, len);
+    return 0;
+}
+
+static int json_put_str(struct json_journal_t *jn, char *dst,
+			const char *src, size_t n, size_t size)
+/* store n bytes at dst and zero the rest of its size, now or on commit */
+{
+    char *dp;
+    size_t nlen = json_varint_len(n);
+
+    if (jn == NULL) {
+	memcpy(dst, src, n);
+	memset(dst + n, '\0', size - n);
+	return 0;
+    }
+    dp = json_journal_reuse(jn, jop_str, dst, size, n);
+    if (dp == NULL) {
+	dp = json_journal_entry(jn, jop_str, dst, size, nlen + n);
+	if (dp == NULL)
+	    return JSON_ERR_JOURNALFULL;
+	dp += json_varint_put(dp, n);
+    }
+    memcpy(dp, src, n);
+    return 0;
+}
+
+static char *json_put_open(struct json_journal_t *jn, char *dst,
+			   size_t *roomp)
+/* start a copy to dst of unknown length, cutting *roomp to what fits */
+{
+    size_t room = jn->size - jn->used - jn->undo, hlen;
+
+    /* the header is written once the length is known; leave it room */
+    hlen = json_varint_len((uint64_t)room << 4)
+	+ json_varint_len(json_journal_where(jn, dst));
+    if (room < hlen)
+	return NULL;
+    room -= hlen;
+    if (*roomp > room)
+	*roomp = room;
+    return jn->buf + jn->used + hlen;
+}
+
+static void json_put_close(struct json_journal_t *jn, char *dst, char *dp,
+			   size_t len)
+/* finish a copy begun by json_put_open() once its length is known */
+{
+    char *hp = jn->buf + jn->used;
+
+    hp += json_varint_put(hp, (uint64_t)len << 4 | jop_copy);
+    hp += json_varint_put(hp, json_journal_where(jn, dst));
+    memmove(hp, dp, len);
+    jn->used = (size_t)(hp - jn->buf) + len;
+}
+
+static int json_put_zero(struct json_journal_t *jn, char *dst, size_t len)
+/* clear len bytes at dst, now or on commit */
+{
+    if (jn == NULL) {
+	memset(dst, '\0', len);
+	return 0;
+    }
+    if (json_journal_entry(jn, jop_zero, dst, len, 0) == NULL)
+	return JSON_ERR_JOURNALFULL;
+    return 0;
+}
+
+static int json_put_bit(struct json_journal_t *jn, char *words, size_t bit,
+			bool val)
+/* json_bit_store(), now or on commit */
+{
+    char *dp;
+
+    if (jn == NULL) {
+	json_bit_store(words, bit, val);
+	return 0;
+    }
+    dp = json_journal_reuse(jn, jop_bit, words, bit, 1);
+    if (dp == NULL
+	&& (dp = json_journal_entry(jn, jop_bit, words, bit, 1)) == NULL)
+	return JSON_ERR_JOURNALFULL;
+    *dp = (char)val;
+    return 0;
+}
+
+static int json_put_clear_bits(struct json_journal_t *jn, char *words,
+			       size_t from, size_t nbits)
+/* clear bits from and up, to the end of the word holding bit nbits - 1 */
+{
+    size_t word = from / 64, nwords = JSON_BITSET_WORDS(nbits);
+
+    if (word >= nwords)
+	return 0;
+    if (from % 64 != 0) {
+	if (jn == NULL)
+	    json_bit_truncate(words + word * sizeof(uint64_t), from % 64);
+	else if (json_journal_entry(jn, jop_trunc,
+				    words + word * sizeof(uint64_t),
+				    from % 64, 0) == NULL)
+	    return JSON_ERR_JOURNALFULL;
+	if (++word == nwords)
+	    return 0;
+    }
+    return json_put_zero(jn, words + word * sizeof(uint64_t),
+			 (nwords - word) * sizeof(uint64_t));
+}
+
+static int json_put_now(struct json_journal_t *jn, void *dst,
+			const void *src, size_t len)
+/* store at once, but undo it if the parse fails; len <= sizeof(size_t) */
+{
+    struct json_jundo_t u;
+
+    if (jn != NULL) {
+	if (sizeof(u) > jn->size - jn->used - jn->undo) {
+	    json_debug_trace((1, "Store journal full.\n"));
+	    return JSON_ERR_JOURNALFULL;
+	}
+	u.dst = dst;
+	u.len = len;
+	memcpy(u.old, dst, len);
+	jn->undo += sizeof(u);
+	memcpy(jn->buf + jn->size - jn->undo, &u, sizeof(u));
+    }
+    memcpy(dst, src, len);
+    return 0;
+}
+
+static void json_journal_end(struct json_journal_t *jn, bool commit)
+/* replay the journal into the targets, or roll back the direct stores */
+{
+    struct json_jentry_t e;
+    struct json_jundo_t u;
+    size_t off;
+
+    if (commit)
+	for (off = 0; off < jn->used; ) {
+	    off = json_journal_decode(jn, off, &e);
+	    if (e.dead)
+		continue;
+	    switch (e.op) {
+	    case jop_copy:
+		memcpy(e.dst, e.data, e.len);
+		break;
+	    case jop_str:
+		memcpy(e.dst, e.data, e.ndata);
+		memset(e.dst + e.ndata, '\0', e.len - e.ndata);
+		break;
+	    case jop_zero:
+		memset(e.dst, '\0', e.len);
+		break;
+	    case jop_trunc:
+		json_bit_truncate(e.dst, e.len);
+		break;
+	    default:
+		json_bit_store(e.dst, e.len, *e.data != 0);
+		break;
+	    }
+	}
+    else
+	/* newest first, so the oldest value is the one left */
+	for (off = jn->size - jn->undo; off < jn->size; off += sizeof(u)) {
+	    memcpy(&u, jn->buf + off, sizeof(u));
+	    memcpy(u.dst, u.old, u.len);
+	}
+    json_debug_trace((1, "Journal %s, %zu bytes used\n",
+		      commit ? "committed" : "discarded",
+		      jn->used + jn->undo));
+    jn->used += jn->undo;
+    jn->undo = 0;
+}
+
+/*
+ * Fast numeric conversion for long arrays.
+ *
+ * strtol(3) and strtod(3) pay for locale handling, base detection and
+ * errno on every call, which dominates the cost of arrays of small
+ * numbers.  The json_strto*() functions are drop-in replacements that
+ * convert plain decimal literals directly and hand anything unusual
+ * (hex, octal, overflow, inf/nan, long mantissas) to the C library, so
+ * results are the same as before.
+ *
+ * Digit runs are found a byte at a time, because the input is only
+ * NUL-terminated and reading ahead of the terminator is not allowed.
+ * Once a run is known, it is converted eight digits per step with SWAR
+ * (SIMD within a register) arithmetic on little-endian machines.
+ */
+
+/* digits in a magnitude guaranteed to fit in a long */
+#define JSON_FAST_DIGITS	(sizeof(long) >= 8 ? 18 : 9)
+
+static uint64_t json_eight_digits(const char *cp)
+/* convert exactly eight ASCII digits */
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint64_t val;
+
+    memcpy(&val, cp, sizeof(val));
+    val = (val & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+    val = (val & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+    return (val & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+#else
+    uint64_t val = 0;
+    int i;
+
+    for (i = 0; i < 8; i++)
+	val = val * 10 + (uint64_t)(cp[i] - '0');
+    return val;
+#endif
+}
+
+static uint64_t json_digit_run(const char *cp, size_t n)
+/* convert a run of n ASCII digits already known to be present */
+{
+    uint64_t val = 0;
+
+    for (; n >= 8; n -= 8, cp += 8)
+	val = val * 100000000 + json_eight_digits(cp);
+    for (; n > 0; n--)
+	val = val * 10 + (uint64_t)(*cp++ - '0');
+    return val;
+}
+
+static size_t json_digit_count(const char *cp)
+{
+    const char *sp = cp;
+
+    while ((unsigned char)(*sp - '0') < 10)
+	sp++;
+    return (size_t)(sp - cp);
+}
+
+static const char *json_fast_integer(const char *cp, bool *negative,
+				     uint64_t *mag)
+/* plain decimal integer; NULL means leave it to the C library */
+{
+    size_t n;
+
+    while (json_isspace(*cp))
+	cp++;
+    *negative = (*cp == '-');
+    if (*cp == '-' || *cp == '+')
+	cp++;
+    n = json_digit_count(cp);
+    /* leading zero may be octal or hex under base 0 */
+    if (n == 0 || n > JSON_FAST_DIGITS || (cp[0] == '0' && n > 1)
+	|| (cp[0] == '0' && (cp[1] == 'x' || cp[1] == 'X')))
+	return NULL;
+    *mag = json_digit_run(cp, n);
+    return cp + n;
+}
+
+static long json_strtol(const char *cp, char **ep)
+/* strtol(cp, ep, 0) */
+{
+    bool negative;
+    uint64_t mag;
+    const char *fp = json_fast_integer(cp, &negative, &mag);
+
+    if (fp == NULL)
+	return strtol(cp, ep, 0);
+    *ep = (char *)fp;
+    return negative ? -(long)mag : (long)mag;
+}
+
+static unsigned long json_strtoul(const char *cp, char **ep)
+/* strtoul(cp, ep, 0) */
+{
+    bool negative;
+    uint64_t mag;
+    const char *fp = json_fast_integer(cp, &negative, &mag);
+
+    if (fp == NULL)
+	return strtoul(cp, ep, 0);
+    *ep = (char *)fp;
+    return negative ? -(unsigned long)mag : (unsigned long)mag;
+}
+
+static double json_strtod(const char *cp, char **ep)
+/*
+ * strtod(cp, ep) for decimals that convert exactly in one step.  Those
+ * read '.' as the decimal point in any locale; the rest go to strtod(3).
+ */
+{
+    /* every power of ten up to 1e22 is exactly representable */
+    static const double pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    const char *sp = cp, *ip, *fp = NULL;
+    size_t ni, nf = 0;
+    int exponent = 0;
+    bool negative;
+    uint64_t mant;
+    double val;
+
+    while (json_isspace(*sp))
+	sp++;
+    negative = (*sp == '-');
+    if (*sp == '-' || *sp == '+')
+	sp++;
+    ip = sp;
+    ni = json_digit_count(ip);
+    sp += ni;
+    if (*sp == '.') {
+	fp = ++sp;
+	nf = json_digit_count(fp);
+	sp += nf;
+    }
+    if (*sp == 'e' || *sp == 'E') {
+	const char *xp = sp + 1;
+	bool xneg = (*xp == '-');
+	size_t nx;
+
+	if (*xp == '-' || *xp == '+')
+	    xp++;
+	nx = json_digit_count(xp);
+	if (nx == 0 || nx > 3)
+	    return strtod(cp, ep);
+	exponent = (int)json_digit_run(xp, nx);
+	if (xneg)
+	    exponent = -exponent;
+	sp = xp + nx;
+    }
+    /*
+     * A mantissa below 2^53 and a power of ten up to 22 are both exact,
+     * so one multiply or divide gives the correctly rounded result.
+     */
+    exponent -= (int)nf;
+    if (ni + nf == 0 || ni + nf > 15 || exponent < -22 || exponent > 22
+	|| (fp != NULL && nf == 0)
+	|| json_isalnum(*sp) || *sp == '.')
+	return strtod(cp, ep);
+    mant = json_digit_run(ip, ni);
+    if (nf > 0)
+	mant = mant * (uint64_t)pow10[nf] + json_digit_run(fp, nf);
+    val = (double)mant;
+    if (exponent < 0)
+	val /= pow10[-exponent];
+    else
+	val *= pow10[exponent];
+    if (ep != NULL)
+	*ep = (char *)sp;
+    return negative ? -val : val;
+}
+
 #ifdef TIME_ENABLE
 static double iso8601_to_unix(char *isotime)
 /* ISO8601 UTC to Unix UTC */
@@ -172,96 +851,751 @@ static double iso8601_to_unix(char *isotime)
     if (dp == NULL)
 	return (double)HUGE_VAL;
     if (*dp == '.')
-	usec = strtod(dp, NULL);
+	usec = json_strtod(dp, NULL);
     else
 	usec = 0;
     return (double)timegm(&tm) + usec;
 }
 #endif /* TIME_ENABLE */
 
-static int json_internal_read_object(const char *cp,
-				     const struct json_attr_t *attrs,
-				     const struct json_array_t *parent,
-				     int offset,
-				     const char **end)
+static int json_read_string(const char **cpp, char *dst, size_t size,
+			    size_t *lenp)
+/*
+ * Decode the body of a JSON string into dst.  *cpp points just past the
+ * opening quote and is left just past the closing one.  At most size
+ * bytes are stored, followed by a NUL.  Runs of plain bytes between
+ * escapes are found with strcspn(3) and copied in bulk.  A NULL dst
+ * only checks the string and measures it.
+ */
 {
-    enum
-    { init, await_attr, in_attr, await_value, in_val_string,
-	in_escape, in_val_token, post_val, post_element
-    } state = 0;
-#ifdef DEBUG_ENABLE
-    char *statenames[] = {
-	"init", "await_attr", "in_attr", "await_value", "in_val_string",
-	"in_escape", "in_val_token", "post_val", "post_element",
-    };
-#endif /* DEBUG_ENABLE */
-    char attrbuf[JSON_ATTR_MAX + 1], *pattr = NULL;
-    char valbuf[JSON_VAL_MAX + 1], *pval = NULL;
-    bool value_quoted = false;
-    char uescape[5];		/* enough space for 4 hex digits and a NUL */
-    const struct json_attr_t *cursor;
-    int substatus, n, maxlen = 0;
+    const char *cp = *cpp;
+    size_t len = 0, run;
     unsigned int u;
-    const struct json_enum_t *mp;
-    char *lptr;
+    int n;
+    char c;
 
-    if (end != NULL)
-	*end = NULL;	/* give it a well-defined value on parse failure */
+    for (;;) {
+	run = strcspn(cp, "\"\\");
+	if (run > size - len) {
+	    json_debug_trace((1, "String value too long.\n"));
+	    return JSON_ERR_STRLONG;
+	}
+	if (dst != NULL)
+	    memcpy(dst + len, cp, run);
+	len += run;
+	cp += run;
+	if (*cp == '"')
+	    break;
+	else if (*cp == '\0') {
+	    json_debug_trace((1, "Unterminated string value.\n"));
+	    return JSON_ERR_BADSTRING;
+	}
+	/* *cp is a backslash */
+	if (len >= size) {
+	    json_debug_trace((1, "String value too long.\n"));
+	    return JSON_ERR_STRLONG;
+	}
+	switch (*++cp) {
+	case 'b':
+	    c = '\b';
+	    break;
+	case 'f':
+	    c = '\f';
+	    break;
+	case 'n':
+	    c = '\n';
+	    break;
+	case 'r':
+	    c = '\r';
+	    break;
+	case 't':
+	    c = '\t';
+	    break;
+	case 'u':
+	    /* ECMA-404 says JSON \u must have 4 hex digits */
+	    for (n = 0, u = 0; n < 4 && json_isxdigit(cp[1]); n++) {
+		++cp;
+		u = u * 16 + (unsigned int)(json_isdigit(*cp)
+		    ? *cp - '0' : (*cp | 0x20) - 'a' + 10);
+	    }
+	    if (n != 4)
+		return JSON_ERR_BADSTRING;
+	    c = (char)(unsigned char)u;	/* truncate values above 0xff */
+	    break;
+	case '\0':
+	    return JSON_ERR_BADSTRING;
+	default:		/* handles double quote and solidus */
+	    c = *cp;
+	    break;
+	}
+	if (dst != NULL)
+	    dst[len] = c;
+	len++;
+	++cp;
+    }
+    if (dst != NULL)
+	dst[len] = '\0';
+    *cpp = cp + 1;
+    if (lenp != NULL)
+	*lenp = len;
+    return 0;
+}
+
+static size_t json_attr_count(const struct json_attr_t *attrs)
+/* number of entries in a template, not counting the terminator */
+{
+    size_t n;
+
+    for (n = 0; attrs[n].attribute != NULL; n++)
+	continue;
+    return n;
+}
+
+static void json_mark_present(uint64_t *present,
+			      const struct json_attr_t *attrs,
+			      const struct json_attr_t *cursor)
+/* record in a presence bitmap that the input supplied this entry */
+{
+    if (present != NULL)
+	json_bit_store((char *)present, (size_t)(cursor - attrs), true);
+}
+
+static bool json_all_present(const uint64_t *required,
+			     const uint64_t *present, size_t words)
+/* have all the required entries been seen? */
+{
+    size_t i;
+
+    for (i = 0; i < words; i++)
+	if ((required[i] & present[i]) != required[i])
+	    return false;
+    return true;
+}
+
+static const char *json_skip_to_close(const char *cp)
+/*
+ * Return a pointer to the } or ] closing the object or array cp is
+ * inside of, or NULL if the input ends first.  Nothing in between is
+ * validated beyond balancing brackets outside of strings.
+ */
+{
+    int depth = 0;
+
+    for (;;) {
+	cp += strcspn(cp, "\"{}[]");
+	switch (*cp) {
+	case '\0':
+	    return NULL;
+	case '"':
+	    /* step over the string, two bytes at a time across escapes */
+	    for (++cp;; cp += 2) {
+		cp += strcspn(cp, "\"\\");
+		if (*cp == '"')
+		    break;
+		if (*cp == '\0' || cp[1] == '\0')
+		    return NULL;
+	    }
+	    break;
+	case '{':
+	case '[':
+	    depth++;
+	    break;
+	default:		/* closing bracket */
+	    if (depth-- == 0)
+		return cp;
+	    break;
+	}
+	cp++;
+    }
+}
+
+/*
+ * Bounded scanners, for input whose end is a length rather than a NUL.
+ * They step over values without interpreting them.
+ */
+
+static const char *json_span_ws(const char *cp, const char *ep)
+{
+    while (cp < ep && json_isspace(*cp))
+	cp++;
+    return cp;
+}
+
+static const char *json_span_string(const char *cp, const char *ep)
+/* cp is at an opening quote; return a pointer past the closing one */
+{
+    for (cp++; cp < ep; cp++)
+	if (*cp == '\\')
+	    cp++;
+	else if (*cp == '"')
+	    return cp + 1;
+    return NULL;
+}
+
+static const char *json_span_value(const char *cp, const char *ep)
+/* return a pointer just past the value at cp, or NULL if it is cut off */
+{
+    int depth = 0;
+
+    do {
+	if (cp >= ep)
+	    return NULL;
+	switch (*cp) {
+	case '"':
+	    if ((cp = json_span_string(cp, ep)) == NULL)
+		return NULL;
+	    continue;		/* already past the string */
+	case '{':
+	case '[':
+	    depth++;
+	    break;
+	case '}':
+	case ']':
+	    if (--depth < 0)
+		return NULL;
+	    break;
+	default:
+	    if (depth == 0) {
+		/* bare token: runs to the next delimiter */
+		while (cp < ep && !json_isspace(*cp)
+		       && *cp != ',' && *cp != '}' && *cp != ']')
+		    cp++;
+		return cp;
+	    }
+	    break;
+	}
+	cp++;
+    } while (depth > 0);
+    return cp;
+}
+
+/*
+ * Working storage for one parse.  The buffers are shared by every
+ * nesting level, since a level only uses them between reading an
+ * attribute name and storing its value.  The frames are the default
+ * stack for nested objects and arrays, and stores go through the
+ * journal when there is one, except inside callback arrays, whose
+ * elements are handed over as soon as they are parsed.  When
+ * validating nothing is stored.
+ */
+struct json_scratch_t {
+    char attrbuf[JSON_ATTR_MAX + 1];
+    char valbuf[JSON_VAL_MAX + 1];
+    struct json_journal_t *journal;
+    int streaming;	/* callback arrays open */
+    int validate;	/* nonzero while values are only checked */
+    const char *limit;	/* end of a counted buffer, else NULL */
+};
+
+#define json_scratch_journal(s)	((s)->streaming > 0 ? NULL : (s)->journal)
+
+static int json_apply_defaults(const struct json_attr_t *attrs,
+			       const struct json_array_t *parent,
+			       int offset, const uint64_t *selected,
+			       struct json_journal_t *jn)
+/* stuff fields with defaults in case they're omitted in the JSON input */
+{
+    const struct json_attr_t *cursor;
+    char *lptr;
+    int status = 0;
 
-    /* stuff fields with defaults in case they're omitted in the JSON input */
     for (cursor = attrs; cursor->attribute != NULL; cursor++)
-	if (!cursor->nodefault) {
+	if (!cursor->nodefault && (selected == NULL
+	    || JSON_BITSET_TEST(selected, cursor - attrs))) {
 	    lptr = json_target_address(cursor, parent, offset);
 	    if (lptr != NULL)
 		switch (cursor->type) {
 		case t_integer:
-		    memcpy(lptr, &cursor->dflt.integer, sizeof(int));
+		    status = json_put(jn, lptr, &cursor->dflt.integer, sizeof(int));
 		    break;
 		case t_uinteger:
-		    memcpy(lptr, &cursor->dflt.uinteger, sizeof(unsigned int));
+		    status = json_put(jn, lptr, &cursor->dflt.uinteger,
+				      sizeof(unsigned int));
 		    break;
 		case t_short:
-		    memcpy(lptr, &cursor->dflt.shortint, sizeof(short));
+		    status = json_put(jn, lptr, &cursor->dflt.shortint, sizeof(short));
 		    break;
 		case t_ushort:
-		    memcpy(lptr, &cursor->dflt.ushortint,
-		           sizeof(unsigned short));
+		    status = json_put(jn, lptr, &cursor->dflt.ushortint,
+				      sizeof(unsigned short));
 		    break;
 		case t_time:
 		case t_real:
-		    memcpy(lptr, &cursor->dflt.real, sizeof(double));
+		    status = json_put(jn, lptr, &cursor->dflt.real,
+				      sizeof(double));
 		    break;
 		case t_string:
 		    if (parent != NULL
-			&& parent->element_type != t_structobject
+			&& parent->element_type == t_object
 			&& offset > 0)
 			return JSON_ERR_NOPARSTR;
-		    lptr[0] = '\0';
+		    status = json_put(jn, lptr, "", 1);
+		    break;
+		case t_arenastring:
+		    {
+			struct json_string_t tmp = {"", 0};
+			status = json_put(jn, lptr, &tmp, sizeof(tmp));
+		    }
 		    break;
 		case t_boolean:
-		    memcpy(lptr, &cursor->dflt.boolean, sizeof(bool));
+		    status = json_put(jn, lptr, &cursor->dflt.boolean,
+				      sizeof(bool));
 		    break;
 		case t_character:
-		    lptr[0] = cursor->dflt.character;
+		    status = json_put(jn, lptr, &cursor->dflt.character, 1);
+		    break;
+		case t_bitset:
+		    status = json_put_bit(jn, lptr,
+					  json_target_bit(cursor, parent, offset),
+					  cursor->dflt.boolean);
 		    break;
 		case t_object:	/* silences a compiler warning */
 		case t_structobject:
+		case t_columnobject:
 		case t_array:
 		case t_check:
 		case t_ignore:
 		    break;
 		}
+	    if (status != 0)
+		return status;
 	}
+    return 0;
+}
 
-    json_debug_trace((1, "JSON parse of '%s' begins.\n", cp));
+static const struct json_attr_t *json_find_attr(const struct json_attr_t *attrs,
+					       const char *name, size_t len)
+/* first template entry matching the len-byte name, or NULL */
+{
+    const struct json_attr_t *cursor;
 
-    /* parse input JSON */
+    for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+	json_debug_trace((2, "Checking against %s\n", cursor->attribute));
+	/* strncmp() stops at a shorter entry's NUL, so [len] is in bounds */
+	if (strncmp(cursor->attribute, name, len) == 0
+	    && cursor->attribute[len] == '\0')
+	    return cursor;
+	if (strcmp(cursor->attribute, "") == 0 && cursor->type == t_ignore)
+	    return cursor;
+    }
+    return NULL;
+}
+
+static const struct json_attr_t *json_order_find(struct json_order_t *order,
+						 const struct json_attr_t *attrs,
+						 int *lastp, const char *name,
+						 size_t len)
+/* json_find_attr(), trying the entry that came next last time first */
+{
+    struct json_order_slot_t *slot = NULL;
+    const struct json_attr_t *cursor;
+
+    if (*lastp < order->nslots)
+	slot = &order->slots[*lastp];
+    if (slot != NULL && slot->next > 0 && (size_t)slot->len == len
+	&& memcmp(attrs[slot->next - 1].attribute, name, len) == 0) {
+	order->hits++;
+	cursor = &attrs[slot->next - 1];
+    } else {
+	json_debug_trace((2, "Order prediction missed %.*s\n",
+			  (int)len, name));
+	order->misses++;
+	cursor = json_find_attr(attrs, name, len);
+	/* a wildcard match says nothing about the next name */
+	if (cursor != NULL && slot != NULL
+	    && strlen(cursor->attribute) == len) {
+	    slot->next = (int)(cursor - attrs) + 1;
+	    slot->len = (int)len;
+	}
+    }
+    if (cursor != NULL)
+	*lastp = (int)(cursor - attrs) + 1;
+    return cursor;
+}
+
+static int json_value_maxlen(const struct json_attr_t *cursor)
+/* longest string value acceptable for a template entry */
+{
+    if (cursor->type == t_string)
+	return (int)cursor->len - 1;
+    else if (cursor->type == t_check)
+	return (int)strlen(cursor->dflt.check);
+    else
+	return JSON_VAL_MAX;
+}
+
+/* what a value looks like, as far as choosing among type specs goes */
+typedef enum {val_string, val_bool, val_uint, val_int, val_real,
+	      val_other} json_valkind;
+
+#define JSON_T(type)	(1u << (type))
+
+/* the entry types each kind of value can select */
+static const unsigned int json_kind_types[] = {
+    [val_string] = JSON_T(t_string) | JSON_T(t_arenastring) | JSON_T(t_time),
+    [val_bool] = JSON_T(t_boolean) | JSON_T(t_bitset),
+    [val_uint] = JSON_T(t_boolean) | JSON_T(t_bitset) | JSON_T(t_integer)
+	| JSON_T(t_uinteger) | JSON_T(t_short) | JSON_T(t_ushort),
+    [val_int] = JSON_T(t_integer) | JSON_T(t_short),
+    [val_real] = JSON_T(t_real),
+    [val_other] = 0,
+};
+
+static json_valkind json_token_kind(const char *tok, unsigned char any,
+				    unsigned char all)
+/* classify a bare token from the OR and AND of its character classes */
+{
+    const char *dp = tok + (*tok == '-');
+
+    if (!json_isdigit(*dp) || (all & JSON_C_NUM) == 0)
+	return (strcmp(tok, "true") == 0 || strcmp(tok, "false") == 0)
+	    ? val_bool : val_other;
+    else if (any & JSON_C_FRAC)
+	return val_real;
+    else
+	return *tok == '-' ? val_int : val_uint;
+}
+
+static json_valkind json_scan_kind(const char *tok)
+/* classify a bare token that was not lexed here */
+{
+    unsigned char any = 0, all = UCHAR_MAX;
+    const char *cp;
+
+    for (cp = tok; *cp != '\0'; cp++) {
+	any |= json_class(*cp);
+	all &= json_class(*cp);
+    }
+    return json_token_kind(tok, any, all);
+}
+
+static int json_check_value(const struct json_attr_t **cursorp,
+			    const struct json_array_t *parent, int offset,
+			    char *valbuf, json_valkind kind)
+/* pick the type spec for a collected value and apply its rules */
+{
+    const struct json_attr_t *cursor = *cursorp;
+    const struct json_enum_t *mp;
+    const unsigned int wanted = json_kind_types[kind];
+    const bool value_quoted = (kind == val_string);
+
+    /*
+     * We know that cursor points at the first spec matching
+     * the current attribute.  We don't know that it's *the*
+     * correct spec; our dialect allows there to be any number
+     * of adjacent ones with the same attrname but different
+     * types.  Here's where we try to seek forward for a
+     * matching type/attr pair if we're not looking at one.
+     * The lexer has already said what kind of value this is,
+     * so each candidate costs one mask test.
+     */
+    while ((wanted & JSON_T(cursor->type)) == 0
+	   && cursor[1].attribute != NULL	/* out of possiblities */
+	   && strcmp(cursor[1].attribute, cursor->attribute) == 0)
+	++cursor;
+    if (value_quoted
+	&& (cursor->type != t_string && cursor->type != t_arenastring
+	    && cursor->type != t_character
+	    && cursor->type != t_check && cursor->type != t_time
+	    && cursor->type != t_ignore && cursor->map == 0)) {
+	json_debug_trace((1, "Saw quoted value when expecting"
+			  " non-string.\n"));
+	return JSON_ERR_QNONSTRING;
+    }
+    if (!value_quoted
+	&& (cursor->type == t_string || cursor->type == t_arenastring
+	    || cursor->type == t_check
+	    || cursor->type == t_time || cursor->map != 0)) {
+	json_debug_trace((1, "Didn't see quoted value when expecting"
+			  " string.\n"));
+	return JSON_ERR_NONQSTRING;
+    }
+    if (cursor->map != 0) {
+	for (mp = cursor->map; mp->name != NULL; mp++)
+	    if (strcmp(mp->name, valbuf) == 0) {
+		goto foundit;
+	    }
+	json_debug_trace((1, "Invalid enumerated value string \"%s\".\n",
+			  valbuf));
+	return JSON_ERR_BADENUM;
+      foundit:
+	(void)snprintf(valbuf, JSON_VAL_MAX + 1, "%d", mp->value);
+    }
+    /* a check has no target address, so test it before looking for one */
+    if (cursor->type == t_check && strcmp(cursor->dflt.check, valbuf) != 0) {
+	json_debug_trace((1, "Required attribute value %s not present.\n",
+			  cursor->dflt.check));
+	/* don't update end here, leave at start of attribute */
+	return JSON_ERR_CHECKFAIL;
+    }
+    if (cursor->type == t_string && parent != NULL
+	&& parent->element_type == t_object && offset > 0)
+	return JSON_ERR_NOPARSTR;
+    if (cursor->type == t_character && strlen(valbuf) > 1)
+	/* don't update end here, leave at value start */
+	return JSON_ERR_STRLONG;
+    *cursorp = cursor;
+    return 0;
+}
+
+static int json_store_value(const struct json_attr_t **cursorp,
+			    const struct json_array_t *parent, int offset,
+			    char *valbuf, json_valkind kind,
+			    struct json_journal_t *jn)
+/* convert a collected value and store it where the template says */
+{
+    const struct json_attr_t *cursor;
+    char *lptr;
+    int status = json_check_value(cursorp, parent, offset, valbuf, kind);
+
+    if (status != 0)
+	return status;
+    cursor = *cursorp;
+    lptr = json_target_address(cursor, parent, offset);
+    if (lptr != NULL)
+	switch (cursor->type) {
+	case t_integer:
+	    {
+		int tmp = atoi(valbuf);
+		status = json_put(jn, lptr, &tmp, sizeof(int));
+	    }
+	    break;
+	case t_uinteger:
+	    {
+		unsigned int tmp = (unsigned int)atoi(valbuf);
+		status = json_put(jn, lptr, &tmp, sizeof(unsigned int));
+	    }
+	    break;
+	case t_short:
+	    {
+		short tmp = atoi(valbuf);
+		status = json_put(jn, lptr, &tmp, sizeof(short));
+	    }
+	    break;
+	case t_ushort:
+	    {
+		unsigned short tmp = (unsigned int)atoi(valbuf);
+		status = json_put(jn, lptr, &tmp, sizeof(unsigned short));
+	    }
+	    break;
+	case t_time:
+#ifdef TIME_ENABLE
+	    {
+		double tmp = iso8601_to_unix(valbuf);
+		status = json_put(jn, lptr, &tmp, sizeof(double));
+	    }
+#endif /* TIME_ENABLE */
+	    break;
+	case t_real:
+	    {
+		double tmp = json_strtod(valbuf, NULL);
+		status = json_put(jn, lptr, &tmp, sizeof(double));
+	    }
+	    break;
+	case t_string:
+	    {
+		size_t vl = strlen(valbuf), cl = cursor->len-1;
+		/* zero the last byte too, so a truncated value ends in NUL */
+		status = json_put_str(jn, lptr, valbuf, vl < cl ? vl : cl,
+				      cursor->len);
+	    }
+	    break;
+	case t_arenastring:
+	    {
+		struct json_arena_t *arena = cursor->addr.astring.arena;
+		struct json_string_t tmp;
+		size_t used;
+
+		if (arena == NULL) {
+		    json_debug_trace((1, "No arena for %s.\n",
+				      cursor->attribute));
+		    return JSON_ERR_NULLPTR;
+		}
+		tmp.len = strlen(valbuf);
+		if (tmp.len + 1 > arena->size - arena->used) {
+		    json_debug_trace((1, "String arena full.\n"));
+		    return JSON_ERR_ARENAFULL;
+		}
+		/* free arena space, so the text itself needs no journal */
+		tmp.ptr = arena->base + arena->used;
+		memcpy(arena->base + arena->used, valbuf, tmp.len + 1);
+		used = arena->used + tmp.len + 1;
+		status = json_put_now(jn, &arena->used, &used, sizeof(used));
+		if (status == 0)
+		    status = json_put(jn, lptr, &tmp, sizeof(tmp));
+	    }
+	    break;
+	case t_boolean:
+	    {
+		bool tmp = (strcmp(valbuf, "true") == 0 || strtol(valbuf, NULL, 0));
+		status = json_put(jn, lptr, &tmp, sizeof(bool));
+	    }
+	    break;
+	case t_bitset:
+	    status = json_put_bit(jn, lptr,
+				  json_target_bit(cursor, parent, offset),
+				  strcmp(valbuf, "true") == 0
+				  || strtol(valbuf, NULL, 0));
+	    break;
+	case t_character:
+	    status = json_put(jn, lptr, valbuf, 1);
+	    break;
+	case t_ignore:  /* silences a compiler warning */
+	case t_object:  /* silences a compiler warning */
+	case t_structobject:
+	case t_columnobject:
+	case t_array:
+	case t_check:
+	    break;
+	}
+    return status;
+}
+
+/*
+ * Nesting is handled without recursion.  Each object or array being
+ * parsed has a json_frame_t on an explicit stack.  When a value turns
+ * out to be a nested object or array, the current frame records where
+ * it stopped and sets up a frame for the child, and json_run_frames()
+ * resumes the parent once the child is done.  The stack is either the
+ * caller's (see json_options_t) or the JSON_DEPTH_MAX frames in the
+ * scratch area.  Running out of it is an error, so deep input costs a
+ * bounded amount of memory and work.
+ */
+
+#define JSON_PUSH	(-1)	/* step result: run the child frame next */
+
+static void json_begin_array(struct json_frame_t *f,
+			     const struct json_array_t *arr, bool update)
+{
+    memset(f, '\0', sizeof(*f));
+    f->is_array = true;
+    f->update = update;
+    f->arr = arr;
+    json_debug_trace((1, "Entered json_read_array()\n"));
+}
+
+static int json_begin_object(struct json_frame_t *f,
+			     const struct json_attr_t *attrs,
+			     const struct json_array_t *parent, int offset,
+			     uint64_t *present,
+			     const struct json_options_t *opts, bool update,
+			     const struct json_scratch_t *scratch)
+/* set up an object frame and apply its defaults */
+{
+    struct json_journal_t *jn;
+    int status;
+
+    memset(f, '\0', sizeof(*f));
+    f->update = update;
+    f->attrs = attrs;
+    f->arr = parent;
+    f->offset = offset;
+    f->present = present;
+    f->opts = opts;
+    f->wanted = true;
+
+    if (opts != NULL && opts->required != NULL && present == NULL)
+	return JSON_ERR_NULLPTR;
+    if (present != NULL) {
+	f->words = JSON_BITSET_WORDS(json_attr_count(attrs));
+	memset(present, '\0', f->words * sizeof(uint64_t));
+    }
+    if (opts != NULL && opts->order != NULL && opts->order->attrs != attrs) {
+	memset(opts->order->slots, '\0',
+	       (size_t)opts->order->nslots * sizeof(struct json_order_slot_t));
+	opts->order->attrs = attrs;
+    }
+
+    /* an update leaves whatever the input omits alone */
+    if (update || scratch->validate)
+	return 0;
+
+    /* stuff fields with defaults in case they're omitted in the JSON input */
+    jn = json_scratch_journal(scratch);
+    if (jn != NULL)
+	f->dflt = jn->used;
+    status = json_apply_defaults(attrs, parent, offset,
+				 opts != NULL ? opts->select : NULL, jn);
+    if (jn != NULL)
+	f->dflt_end = f->dflt_next = jn->used;
+    return status;
+}
+
+static int json_push_object(struct json_frame_t *child,
+			    const struct json_attr_t *attrs,
+			    const struct json_array_t *parent, int offset,
+			    uint64_t *present, bool update,
+			    const struct json_scratch_t *scratch)
+/* start a nested object in the next frame, if there is one */
+{
+    int status;
+
+    if (child == NULL) {
+	json_debug_trace((1, "Objects nested too deeply.\n"));
+	return JSON_ERR_DEPTH;
+    }
+    status = json_begin_object(child, attrs, parent, offset, present, NULL,
+			       update, scratch);
+    return status != 0 ? status : JSON_PUSH;
+}
+
+static int json_object_step(struct json_frame_t *f, const char **cpp,
+			    struct json_frame_t *child,
+			    struct json_scratch_t *scratch, const char **end)
+/* run an object frame until it is finished or needs a child frame */
+{
+    enum
+    { init, await_attr, in_attr, await_value,
+	in_val_token, post_val, post_element
+    } state = f->state;
+#ifdef DEBUG_ENABLE
+    static const char *const statenames[] = {
+	"init", "await_attr", "in_attr", "await_value",
+	"in_val_token", "post_val", "post_element",
+    };
+#endif /* DEBUG_ENABLE */
+    const struct json_attr_t *attrs = f->attrs;
+    const struct json_array_t *parent = f->arr;
+    const struct json_options_t *opts = f->opts;
+    int offset = f->offset;
+    uint64_t *present = f->present;
+    char *const attrbuf = scratch->attrbuf;
+    const char *kp;
+    size_t klen;
+    char *const valbuf = scratch->valbuf, *pval = NULL;
+    json_valkind valkind = val_other;
+    unsigned char tokany = 0, tokall = 0, cls;
+    const struct json_attr_t *cursor = f->cursor;
+    int substatus, maxlen = 0;
+    const uint64_t *required = opts != NULL ? opts->required : NULL;
+    const uint64_t *selected = opts != NULL ? opts->select : NULL;
+    struct json_order_t *order = opts != NULL ? opts->order : NULL;
+    int lastattr = f->lastattr;
+    bool satisfied = f->satisfied, wanted = f->wanted;
+    size_t words = f->words;
+    const char *cp = *cpp;
+
+    if (state == init)
+	json_debug_trace((1, "JSON parse of '%s' begins.\n", cp));
+    else if (f->resuming) {
+	/* the nested array or object at cursor has been read */
+	f->resuming = false;
+	if (!wanted)
+	    scratch->validate--;
+	if (cursor->type == t_array)
+	    ++cp;	/* step past the closing ] */
+	json_mark_present(present, attrs, cursor);
+	if (required != NULL)
+	    satisfied = json_all_present(required, present, words);
+    }
+
+    /* parse input JSON */
     for (; *cp != '\0'; cp++) {
 	json_debug_trace((2, "State %-14s, looking at '%c' (%p)\n",
 			  statenames[state], *cp, cp));
 	switch (state) {
 	case init:
-	    if (isspace((unsigned char) *cp))
+	    if (json_isspace(*cp))
 		continue;
 	    else if (*cp == '{')
 		state = await_attr;
@@ -274,11 +1608,10 @@ static int json_internal_read_object(const char *cp,
 	    }
 	    break;
 	case await_attr:
-	    if (isspace((unsigned char) *cp))
+	    if (json_isspace(*cp))
 		continue;
 	    else if (*cp == '"') {
 		state = in_attr;
-		pattr = attrbuf;
 		if (end != NULL)
 		    *end = cp;
 	    } else if (*cp == '}')
@@ -291,50 +1624,49 @@ static int json_internal_read_object(const char *cp,
 	    }
 	    break;
 	case in_attr:
-	    if (pattr == NULL)
-		/* don't update end here, leave at attribute start */
-		return JSON_ERR_NULLPTR;
-	    if (*cp == '"') {
-		*pattr++ = '\0';
-		json_debug_trace((1, "Collected attribute name %s\n",
-				  attrbuf));
-		for (cursor = attrs; cursor->attribute != NULL; cursor++) {
-		    json_debug_trace((2, "Checking against %s\n",
-				      cursor->attribute));
-		    if (strcmp(cursor->attribute, attrbuf) == 0)
-			break;
-		    if (strcmp(cursor->attribute, "") == 0 &&
-			    cursor->type == t_ignore) {
-			break;
-		    }
-		}
-		if (cursor->attribute == NULL) {
-		    json_debug_trace((1,
-				      "Unknown attribute name '%s'"
-                                      " (attributes begin with '%s').\n",
-				      attrbuf, attrs->attribute));
+	    /* match the name where it lies unless it has escapes */
+	    kp = cp;
+	    cp += strcspn(cp, "\"\\");
+	    if (*cp == '\0') {
+		--cp;	/* let the loop see the end of input */
+		break;
+	    } else if (*cp == '"')
+		klen = (size_t)(cp - kp);
+	    else {
+		cp = kp;
+		substatus = json_read_string(&cp, attrbuf, JSON_ATTR_MAX - 1,
+					     &klen);
+		if (substatus == JSON_ERR_STRLONG) {
+		    json_debug_trace((1, "Escaped attribute name too long.\n"));
 		    /* don't update end here, leave at attribute start */
-		    return JSON_ERR_BADATTR;
-		}
-		state = await_value;
-		if (cursor->type == t_string)
-		    maxlen = (int)cursor->len - 1;
-		else if (cursor->type == t_check)
-		    maxlen = (int)strlen(cursor->dflt.check);
-		else if (cursor->type == t_time || cursor->type == t_ignore)
-		    maxlen = JSON_VAL_MAX;
-		else if (cursor->map != NULL)
-		    maxlen = (int)sizeof(valbuf) - 1;
-		pval = valbuf;
-	    } else if (pattr >= attrbuf + JSON_ATTR_MAX - 1) {
-		json_debug_trace((1, "Attribute name too long.\n"));
+		    return JSON_ERR_ATTRLEN;
+		} else if (substatus != 0)
+		    return substatus;
+		--cp;	/* closing quote is re-consumed by cp++ at end of loop */
+		kp = attrbuf;
+	    }
+	    json_debug_trace((1, "Collected attribute name %.*s\n",
+			      (int)klen, kp));
+	    if (order != NULL)
+		cursor = json_order_find(order, attrs, &lastattr, kp, klen);
+	    else
+		cursor = json_find_attr(attrs, kp, klen);
+	    if (cursor == NULL) {
+		json_debug_trace((1,
+				  "Unknown attribute name '%.*s'"
+				  " (attributes begin with '%s').\n",
+				  (int)klen, kp, attrs->attribute));
 		/* don't update end here, leave at attribute start */
-		return JSON_ERR_ATTRLEN;
-	    } else
-		*pattr++ = *cp;
+		return JSON_ERR_BADATTR;
+	    }
+	    state = await_value;
+	    wanted = (selected == NULL
+		      || JSON_BITSET_TEST(selected, cursor - attrs));
+	    maxlen = json_value_maxlen(cursor);
+	    pval = valbuf;
 	    break;
 	case await_value:
-	    if (isspace((unsigned char) *cp) || *cp == ':')
+	    if (json_isspace(*cp) || *cp == ':')
 		continue;
 	    else if (*cp == '[') {
 		if (cursor->type != t_array) {
@@ -344,10 +1676,16 @@ static int json_internal_read_object(const char *cp,
 			*end = cp;
 		    return JSON_ERR_NOARRAY;
 		}
-		substatus = json_read_array(cp, &cursor->addr.array, &cp);
-		if (substatus != 0)
-		    return substatus;
-		state = post_element;
+		if (child == NULL) {
+		    json_debug_trace((1, "Arrays nested too deeply.\n"));
+		    return JSON_ERR_DEPTH;
+		}
+		json_begin_array(child, &cursor->addr.array, f->update);
+		/* a deselected array is checked but not stored */
+		if (!wanted)
+		    scratch->validate++;
+		substatus = JSON_PUSH;
+		goto suspend;
 	    } else if (cursor->type == t_array) {
 		json_debug_trace((1,
 				  "Array element was specified, but no [.\n"));
@@ -362,11 +1700,14 @@ static int json_internal_read_object(const char *cp,
 			*end = cp;
 		    return JSON_ERR_NOARRAY;
 		}
-		substatus = json_read_object(cp, cursor->addr.attrs, &cp);
-		if (substatus != 0)
+		if (!wanted)
+		    scratch->validate++;
+		substatus = json_push_object(child, cursor->addr.attrs,
+					     NULL, 0, NULL, f->update, scratch);
+		if (substatus != JSON_PUSH)
 		    return substatus;
-		--cp;	// last } will be re-consumed by cp++ at end of loop
-		state = post_element;
+		/* resume at the child's end, just past its closing } */
+		goto suspend;
 	    } else if (cursor->type == t_object) {
 		json_debug_trace((1,
 				  "Object element was specified, but no {.\n"));
@@ -374,245 +1715,109 @@ static int json_internal_read_object(const char *cp,
 		    *end = cp;
 		return JSON_ERR_NOCURLY;
 	    } else if (*cp == '"') {
-		value_quoted = true;
-		state = in_val_string;
-		pval = valbuf;
+		valkind = val_string;
+		++cp;
+		/* valbuf holds at most maxlen + 1 characters of a string */
+		substatus = json_read_string(&cp, valbuf,
+					     maxlen < JSON_VAL_MAX - 1
+					     ? (size_t)(maxlen + 1)
+					     : JSON_VAL_MAX, NULL);
+		if (substatus != 0)
+		    /* don't update end here, leave at value start */
+		    return substatus;
+		json_debug_trace((1, "Collected string value %s\n", valbuf));
+		--cp;	/* closing quote is re-consumed by cp++ at end of loop */
+		state = post_val;
 	    } else {
-		value_quoted = false;
 		state = in_val_token;
 		pval = valbuf;
+		tokany = tokall = json_class(*cp);
 		*pval++ = *cp;
 	    }
 	    break;
-	case in_val_string:
-	    if (pval == NULL)
-		/* don't update end here, leave at value start */
-		return JSON_ERR_NULLPTR;
-	    if (*cp == '\\')
-		state = in_escape;
-	    else if (*cp == '"') {
-		*pval++ = '\0';
-		json_debug_trace((1, "Collected string value %s\n", valbuf));
-		state = post_val;
-	    } else if (pval > valbuf + JSON_VAL_MAX - 1
-		       || pval > valbuf + maxlen) {
-		json_debug_trace((1, "String value too long.\n"));
-		/* don't update end here, leave at value start */
-		return JSON_ERR_STRLONG;	/*  */
-	    } else
-		*pval++ = *cp;
-	    break;
-	case in_escape:
-	    if (pval == NULL)
-		/* don't update end here, leave at value start */
-		return JSON_ERR_NULLPTR;
-	    else if (pval > valbuf + JSON_VAL_MAX - 1
-		       || pval > valbuf + maxlen) {
-		json_debug_trace((1, "String value too long.\n"));
-		/* don't update end here, leave at value start */
-		return JSON_ERR_STRLONG;	/*  */
-	    }
-	    switch (*cp) {
-	    case 'b':
-		*pval++ = '\b';
-		break;
-	    case 'f':
-		*pval++ = '\f';
-		break;
-	    case 'n':
-		*pval++ = '\n';
-		break;
-	    case 'r':
-		*pval++ = '\r';
-		break;
-	    case 't':
-		*pval++ = '\t';
-		break;
-	    case 'u':
-                cp++;                   /* skip the 'u' */
-		for (n = 0; n < 4 && isxdigit(*cp); n++)
-		    uescape[n] = *cp++;
-                uescape[n] = '\0';      /* terminate */
-		--cp;
-                /* ECMA-404 says JSON \u must have 4 hex digits */
-		if ((4 != n) || (1 != sscanf(uescape, "%4x", &u))) {
-		    return JSON_ERR_BADSTRING;
-                }
-		*pval++ = (unsigned char)u;  /* truncate values above 0xff */
-		break;
-	    default:		/* handles double quote and solidus */
-		*pval++ = *cp;
-		break;
-	    }
-	    state = in_val_string;
-	    break;
 	case in_val_token:
 	    if (pval == NULL)
 		/* don't update end here, leave at value start */
 		return JSON_ERR_NULLPTR;
-	    if (isspace((unsigned char) *cp) || *cp == ',' || *cp == '}') {
+	    /* copy up to whitespace, comma or }, noting what we pass */
+	    while (((cls = json_class(*cp)) & JSON_C_DELIM) == 0
+		   && pval <= valbuf + JSON_VAL_MAX - 1) {
+		tokany |= cls;
+		tokall &= cls;
+		*pval++ = *cp++;
+	    }
+	    if (*cp == '\0')
+		--cp;	/* let the loop see the end of input */
+	    else if (json_isdelim(*cp)) {
 		*pval = '\0';
+		valkind = json_token_kind(valbuf, tokany, tokall);
 		json_debug_trace((1, "Collected token value %s.\n", valbuf));
 		state = post_val;
 		if (*cp == '}' || *cp == ',')
 		    --cp;
-	    } else if (pval > valbuf + JSON_VAL_MAX - 1) {
+	    } else {
 		json_debug_trace((1, "Token value too long.\n"));
 		/* don't update end here, leave at value start */
 		return JSON_ERR_TOKLONG;
-	    } else
-		*pval++ = *cp;
+	    }
 	    break;
 	case post_val:
 	    // Ignore whitespace after either string or token values.
-	    if (isspace(*cp)) {
-		    while (*cp != '\0' && isspace((unsigned char) *cp)) {
+	    if (json_isspace(*cp)) {
+		    while (*cp != '\0' && json_isspace(*cp)) {
 			++cp;
 		    }
 		    json_debug_trace((1, "Skipped trailing whitespace: value \"%s\"\n", valbuf));
 	    }
-	    /*
-	     * We know that cursor points at the first spec matching
-	     * the current attribute.  We don't know that it's *the*
-	     * correct spec; our dialect allows there to be any number
-	     * of adjacent ones with the same attrname but different
-	     * types.  Here's where we try to seek forward for a
-	     * matching type/attr pair if we're not looking at one.
-	     */
-	    for (;;) {
-		int seeking = cursor->type;
-		if (value_quoted && (cursor->type == t_string
-                    || cursor->type == t_time))
-		    break;
-		if ((strcmp(valbuf, "true")==0 || strcmp(valbuf, "false")==0
-			|| isdigit((unsigned char) valbuf[0]))
-			&& seeking == t_boolean)
-		    break;
-		if (isdigit((unsigned char) valbuf[0])) {
-		    bool decimal = strchr(valbuf, '.') != NULL;
-		    if (decimal && seeking == t_real)
-			break;
-		    if (!decimal && (seeking == t_integer
-                                     || seeking == t_uinteger))
-			break;
+	    if (!wanted)
+		json_debug_trace((1, "Not converting deselected %s\n",
+				  cursor->attribute));
+	    /* a deselected value is still checked, just not stored */
+	    if (!wanted || scratch->validate > 0)
+		substatus = json_check_value(&cursor, parent, offset,
+					     valbuf, valkind);
+	    else {
+		struct json_journal_t *jn = json_scratch_journal(scratch);
+
+		/* the value may take over its default's journal entry */
+		if (jn != NULL) {
+		    jn->dflt = f->dflt;
+		    jn->dflt_end = f->dflt_end;
+		    jn->dflt_next = f->dflt_next;
 		}
-		if (cursor[1].attribute==NULL)	/* out of possiblities */
-		    break;
-		if (strcmp(cursor[1].attribute, attrbuf)!=0)
-		    break;
-		++cursor;
-	    }
-	    if (value_quoted
-		&& (cursor->type != t_string && cursor->type != t_character
-		    && cursor->type != t_check && cursor->type != t_time
-		    && cursor->type != t_ignore && cursor->map == 0)) {
-		json_debug_trace((1, "Saw quoted value when expecting"
-                                  " non-string.\n"));
-		return JSON_ERR_QNONSTRING;
-	    }
-	    if (!value_quoted
-		&& (cursor->type == t_string || cursor->type == t_check
-		    || cursor->type == t_time || cursor->map != 0)) {
-		json_debug_trace((1, "Didn't see quoted value when expecting"
-                                  " string.\n"));
-		return JSON_ERR_NONQSTRING;
-	    }
-	    if (cursor->map != 0) {
-		for (mp = cursor->map; mp->name != NULL; mp++)
-		    if (strcmp(mp->name, valbuf) == 0) {
-			goto foundit;
-		    }
-		json_debug_trace((1, "Invalid enumerated value string \"%s\".\n",
-				  valbuf));
-		return JSON_ERR_BADENUM;
-	      foundit:
-		(void)snprintf(valbuf, sizeof(valbuf), "%d", mp->value);
-	    }
-	    lptr = json_target_address(cursor, parent, offset);
-	    if (lptr != NULL)
-		switch (cursor->type) {
-		case t_integer:
-		    {
-			int tmp = atoi(valbuf);
-			memcpy(lptr, &tmp, sizeof(int));
-		    }
-		    break;
-		case t_uinteger:
-		    {
-			unsigned int tmp = (unsigned int)atoi(valbuf);
-			memcpy(lptr, &tmp, sizeof(unsigned int));
-		    }
-		    break;
-		case t_short:
-		    {
-			short tmp = atoi(valbuf);
-			memcpy(lptr, &tmp, sizeof(short));
-		    }
-		    break;
-		case t_ushort:
-		    {
-			unsigned short tmp = (unsigned int)atoi(valbuf);
-			memcpy(lptr, &tmp, sizeof(unsigned short));
-		    }
-		    break;
-		case t_time:
-#ifdef TIME_ENABLE
-		    {
-			double tmp = iso8601_to_unix(valbuf);
-			memcpy(lptr, &tmp, sizeof(double));
-		    }
-#endif /* TIME_ENABLE */
-		    break;
-		case t_real:
-		    {
-			double tmp = atof(valbuf);
-			memcpy(lptr, &tmp, sizeof(double));
-		    }
-		    break;
-		case t_string:
-		    if (parent != NULL
-			&& parent->element_type != t_structobject
-			&& offset > 0)
-			return JSON_ERR_NOPARSTR;
-		    else {
-			size_t vl = strlen(valbuf), cl = cursor->len-1;
-			memset(lptr, '\0', cl);
-			memcpy(lptr, valbuf, vl < cl ? vl : cl);
-		    }
-		    break;
-		case t_boolean:
-		    {
-			bool tmp = (strcmp(valbuf, "true") == 0 || strtol(valbuf, NULL, 0));
-			memcpy(lptr, &tmp, sizeof(bool));
-		    }
-		    break;
-		case t_character:
-		    if (strlen(valbuf) > 1)
-			/* don't update end here, leave at value start */
-			return JSON_ERR_STRLONG;
-		    else
-			lptr[0] = valbuf[0];
-		    break;
-		case t_ignore:	/* silences a compiler warning */
-		case t_object:	/* silences a compiler warning */
-		case t_structobject:
-		case t_array:
-		    break;
-		case t_check:
-		    if (strcmp(cursor->dflt.check, valbuf) != 0) {
-			json_debug_trace((1, "Required attribute value %s"
-                                          " not present.\n",
-					  cursor->dflt.check));
-			/* don't update end here, leave at start of attribute */
-			return JSON_ERR_CHECKFAIL;
-		    }
-		    break;
+		substatus = json_store_value(&cursor, parent, offset,
+					     valbuf, valkind, jn);
+		if (jn != NULL) {
+		    f->dflt_next = jn->dflt_next;
+		    jn->dflt = jn->dflt_end = 0;
 		}
+	    }
+	    if (substatus != 0)
+		return substatus;
+	    json_mark_present(present, attrs, cursor);
+	    if (required != NULL)
+		satisfied = json_all_present(required, present, words);
 	    __attribute__ ((fallthrough));
 	case post_element:
-	    if (isspace((unsigned char) *cp))
+	    if (json_isspace(*cp))
 		continue;
-	    else if (*cp == ',')
+	    else if (*cp == ',' && satisfied) {
+		json_debug_trace((1, "All required attributes seen.\n"));
+		if (opts->return_early) {
+		    /* leave the caller at the comma */
+		    *cpp = cp;
+		    if (end != NULL)
+			*end = cp;
+		    return 0;
+		}
+		cp = json_skip_to_close(cp);
+		if (cp == NULL || *cp != '}') {
+		    json_debug_trace((1, "Unbalanced object while skipping\n"));
+		    return JSON_ERR_BADTRAIL;
+		}
+		++cp;
+		goto good_parse;
+	    } else if (*cp == ',')
 		state = await_attr;
 	    else if (*cp == '}') {
 		++cp;
@@ -629,120 +1834,302 @@ static int json_internal_read_object(const char *cp,
 
   good_parse:
     /* in case there's another object following, consume trailing WS */
-    while (*cp != '\0' && isspace((unsigned char) *cp))
+    while (cp != scratch->limit && *cp != '\0' && json_isspace(*cp))
 	++cp;
+    *cpp = cp;
     if (end != NULL)
 	*end = cp;
     json_debug_trace((1, "JSON parse ends.\n"));
     return 0;
+
+  suspend:
+    /* keep our place while the child frame runs */
+    f->state = post_element;
+    f->cursor = cursor;
+    f->lastattr = lastattr;
+    f->wanted = wanted;
+    f->satisfied = satisfied;
+    *cpp = cp;
+    return substatus;
 }
 
-int json_read_array(const char *cp, const struct json_array_t *arr,
-		    const char **end)
+static int json_update_slot(const struct json_array_t *arr, const char *cp,
+			    int offset, char *valbuf, int *slotp,
+			    struct json_journal_t *jn)
+/* the element an update applies to: the one with the same key, or the next */
 {
-    int substatus, offset, arrcount;
-    char *tp;
-
-    if (end != NULL)
-	*end = NULL;	/* give it a well-defined value on parse failure */
-
-    json_debug_trace((1, "Entered json_read_array()\n"));
+    const struct json_attr_t *key;
+    const char *closer;
+    size_t len, off;
+    char *lptr;
+    int i, n, status;
+    union {
+	int integer;
+	unsigned int uinteger;
+    } val;
 
-    while (isspace((unsigned char) *cp))
+    *slotp = offset;
+    if (arr->element_type != t_structobject || arr->arr.objects.key == NULL
+	|| arr->count == NULL)
+	return 0;
+    for (key = arr->arr.objects.subtype; key->attribute != NULL; key++)
+	if (strcmp(key->attribute, arr->arr.objects.key) == 0)
+	    break;
+    if (key->attribute == NULL) {
+	json_debug_trace((1, "Update key %s is not in the subtype.\n",
+			  arr->arr.objects.key));
+	return JSON_ERR_BADATTR;
+    }
+    while (json_isspace(*cp))
 	cp++;
-    if (*cp != '[') {
-	json_debug_trace((1, "Didn't find expected array start\n"));
-	return JSON_ERR_ARRAYSTART;
+    closer = *cp == '{' ? json_skip_to_close(cp + 1) : NULL;
+    if (closer == NULL || *closer != '}')
+	return 0;	/* let the element parse report the syntax error */
+    len = (size_t)(closer + 1 - cp);
+    switch (key->type) {
+    case t_string:
+	status = json_get_string(cp, len, key->attribute, valbuf,
+				 JSON_VAL_MAX + 1);
+	break;
+    case t_integer:
+	status = json_get_integer(cp, len, key->attribute, &val.integer);
+	break;
+    case t_uinteger:
+	status = json_get_uinteger(cp, len, key->attribute, &val.uinteger);
+	break;
+    default:
+	json_debug_trace((1, "Update key %s is not a string or integer.\n",
+			  arr->arr.objects.key));
+	return JSON_ERR_SUBTYPE;
+    }
+    /* compare as stored: a long string key was cut to len - 1 bytes */
+    if (status == 0 && key->type == t_string && key->len > 0
+	&& strlen(valbuf) >= key->len)
+	valbuf[key->len - 1] = '\0';
+    n = *(arr->count);
+    if (status == 0)
+	for (i = 0; i < n; i++) {
+	    lptr = arr->arr.objects.base + arr->arr.objects.stride * i
+		+ key->addr.offset;
+	    if (key->type == t_string ? strcmp(lptr, valbuf) == 0
+		: memcmp(lptr, &val, sizeof(int)) == 0) {
+		json_debug_trace((1, "Update of element %d by key\n", i));
+		*slotp = i;
+		return 0;
+	    }
+	}
+    else if (status != JSON_ERR_NOTFOUND)
+	return status;
+    /* a new key, or none at all: take the next free element */
+    if (n >= arr->maxlen) {
+	json_debug_trace((1, "No room for a new element.\n"));
+	return JSON_ERR_SUBTOOLONG;
+    }
+    *slotp = n;
+    /*
+     * The key goes into the new element at once, like the count, so a
+     * later element with the same key finds it even when the element's
+     * own stores are still waiting in the journal.
+     */
+    lptr = arr->arr.objects.base + arr->arr.objects.stride * n
+	+ key->addr.offset;
+    if (status == JSON_ERR_NOTFOUND)
+	status = 0;	/* no key to store */
+    else if (key->type == t_string) {
+	/* undo records hold a word each, so a string goes in pieces */
+	len = strlen(valbuf) + 1;
+	for (off = 0; off < len && status == 0; off += sizeof(size_t))
+	    status = json_put_now(jn, lptr + off, valbuf + off,
+				  len - off < sizeof(size_t)
+				  ? len - off : sizeof(size_t));
     } else
-	cp++;
+	status = json_put_now(jn, lptr, &val, sizeof(int));
+    if (status != 0)
+	return status;
+    n++;
+    return json_put_now(jn, arr->count, &n, sizeof(n));
+}
 
-    tp = arr->arr.strings.store;
-    arrcount = 0;
+static int json_array_step(struct json_frame_t *f, const char **cpp,
+			   struct json_frame_t *child,
+			   struct json_scratch_t *scratch, const char **end)
+/* run an array frame until it is finished or needs a child frame */
+{
+    const struct json_array_t *arr = f->arr;
+    const bool validate = scratch->validate > 0;
+    const bool streaming = arr->callback != NULL;
+    struct json_journal_t *jn = streaming ? NULL
+	: json_scratch_journal(scratch);
+    int offset = f->offset, arrcount = f->count, slot, substatus;
+    bool update;
+    size_t presentwords = f->words;
+    char *tp = f->tp;
+    const char *cp = *cpp;
 
-    /* Check for empty array */
-    while (isspace((unsigned char) *cp))
-	cp++;
-    if (*cp == ']')
-	goto breakout;
+    if (f->state == 0) {
+	while (json_isspace(*cp))
+	    cp++;
+	if (*cp != '[') {
+	    json_debug_trace((1, "Didn't find expected array start\n"));
+	    return JSON_ERR_ARRAYSTART;
+	} else
+	    cp++;
+
+	f->state = 1;
+	tp = f->tp = arr->arr.strings.store;
+	if (streaming)
+	    scratch->streaming++;
+	if ((arr->element_type == t_object
+	     || arr->element_type == t_structobject
+	     || arr->element_type == t_columnobject)
+	    && arr->arr.objects.present != NULL && !validate)
+	    presentwords = f->words =
+		JSON_BITSET_WORDS(json_attr_count(arr->arr.objects.subtype));
+
+	/* Check for empty array */
+	while (json_isspace(*cp))
+	    cp++;
+	if (*cp == ']')
+	    goto breakout;
+    }
 
-    for (offset = 0; offset < arr->maxlen; offset++) {
+    /* a callback array reuses element 0 and has no length limit */
+    for (; offset < arr->maxlen || streaming; offset++) {
 	char *ep = NULL;
+
+	slot = streaming ? 0 : offset;
+	if (f->resuming) {
+	    /* element offset was an object and has been read */
+	    f->resuming = false;
+	    goto element_done;
+	}
 	json_debug_trace((1, "Looking at %s\n", cp));
+	substatus = 0;
+	if (streaming)
+	    tp = arr->arr.strings.store;
 	switch (arr->element_type) {
 	case t_string:
-	    if (isspace((unsigned char) *cp))
+	    if (json_isspace(*cp))
 		cp++;
 	    if (*cp != '"')
 		return JSON_ERR_BADSTRING;
 	    else
 		++cp;
-	    arr->arr.strings.ptrs[offset] = tp;
-	    for (; tp - arr->arr.strings.store < arr->arr.strings.storelen;
-		 tp++)
-		if (*cp == '"') {
-		    ++cp;
-		    *tp++ = '\0';
-		    goto stringend;
-		} else if (*cp == '\0') {
+	    {
+		/* room for the string and its NUL in what is left of store */
+		ptrdiff_t left = arr->arr.strings.storelen
+		    - (tp - arr->arr.strings.store);
+		size_t len, room = left > 0 ? (size_t)left : 0;
+		char *dp = validate ? NULL : tp;
+
+		/* under a journal the text is decoded into its entry */
+		if (jn != NULL && !validate && room > 0
+		    && (dp = json_put_open(jn, tp, &room)) == NULL)
+		    return JSON_ERR_JOURNALFULL;
+		if (room < 1
+		    || json_read_string(&cp, dp, room - 1, &len) != 0) {
+		    if (jn != NULL && left > 0 && room < (size_t)left)
+			return JSON_ERR_JOURNALFULL;
 		    json_debug_trace((1,
 				      "Bad string syntax in string list.\n"));
 		    return JSON_ERR_BADSTRING;
-		} else {
-		    *tp = *cp++;
 		}
-	    json_debug_trace((1, "Bad string syntax in string list.\n"));
-	    return JSON_ERR_BADSTRING;
-	  stringend:
+		if (jn != NULL && !validate)
+		    json_put_close(jn, tp, dp, len + 1);
+		if (!validate)
+		    substatus = json_put(jn, &arr->arr.strings.ptrs[slot],
+					 &tp, sizeof(tp));
+		tp += len + 1;
+	    }
 	    break;
 	case t_object:
 	case t_structobject:
-	    substatus =
-		json_internal_read_object(cp, arr->arr.objects.subtype, arr,
-					  offset, &cp);
-	    if (substatus != 0) {
-		if (end != NULL)
-		    end = &cp;
-		return substatus;
+	case t_columnobject:
+	    update = f->update && !streaming;
+	    if (update) {
+		int before = arr->count != NULL ? *(arr->count) : arr->maxlen;
+
+		substatus = json_update_slot(arr, cp, offset, scratch->valbuf,
+					     &slot, jn);
+		if (substatus != 0)
+		    return substatus;
+		/* an element the update creates starts from its defaults */
+		update = slot < before;
 	    }
-	    break;
+	    /* keep our place while the element is read by a child frame */
+	    f->offset = offset;
+	    f->count = arrcount;
+	    f->tp = tp;
+	    *cpp = cp;
+	    return json_push_object(child, arr->arr.objects.subtype, arr,
+				    slot,
+				    presentwords > 0
+				    ? arr->arr.objects.present
+				    + slot * presentwords : NULL, update,
+				    scratch);
 	case t_integer:
-	    arr->arr.integers.store[offset] = (int)strtol(cp, &ep, 0);
-	    if (ep == cp)
-		return JSON_ERR_BADNUM;
-	    else
+	    {
+		int val = (int)json_strtol(cp, &ep);
+
+		if (ep == cp)
+		    return JSON_ERR_BADNUM;
 		cp = ep;
+		if (!validate)
+		    substatus = json_put(jn, &arr->arr.integers.store[slot],
+					 &val, sizeof(val));
+	    }
 	    break;
 	case t_uinteger:
-	    arr->arr.uintegers.store[offset] = (unsigned int)strtoul(cp,
-                                                                     &ep, 0);
-	    if (ep == cp)
-		return JSON_ERR_BADNUM;
-	    else
+	    {
+		unsigned int val = (unsigned int)json_strtoul(cp, &ep);
+
+		if (ep == cp)
+		    return JSON_ERR_BADNUM;
 		cp = ep;
+		if (!validate)
+		    substatus = json_put(jn, &arr->arr.uintegers.store[slot],
+					 &val, sizeof(val));
+	    }
 	    break;
 	case t_short:
-	    arr->arr.shorts.store[offset] = (short)strtol(cp, &ep, 0);
- 	    if (ep == cp)
- 		return JSON_ERR_BADNUM;
- 	    else
- 		cp = ep;
- 	    break;
+	    {
+		short val = (short)json_strtol(cp, &ep);
+
+		if (ep == cp)
+		    return JSON_ERR_BADNUM;
+		cp = ep;
+		if (!validate)
+		    substatus = json_put(jn, &arr->arr.shorts.store[slot],
+					 &val, sizeof(val));
+	    }
+	    break;
 	case t_ushort:
-	    arr->arr.ushorts.store[offset] = (unsigned short)strtol(cp, &ep, 0);
- 	    if (ep == cp)
- 		return JSON_ERR_BADNUM;
- 	    else
- 		cp = ep;
- 	    break;
+	    {
+		unsigned short val = (unsigned short)json_strtol(cp, &ep);
+
+		if (ep == cp)
+		    return JSON_ERR_BADNUM;
+		cp = ep;
+		if (!validate)
+		    substatus = json_put(jn, &arr->arr.ushorts.store[slot],
+					 &val, sizeof(val));
+	    }
+	    break;
 #ifdef TIME_ENABLE
 	case t_time:
 	    if (*cp != '"')
 		return JSON_ERR_BADSTRING;
 	    else
 		++cp;
-	    arr->arr.reals.store[offset] = iso8601_to_unix((char *)cp);
-	    if (arr->arr.reals.store[offset] >= HUGE_VAL)
-		return JSON_ERR_BADNUM;
+	    {
+		double val = iso8601_to_unix((char *)cp);
+
+		if (val >= HUGE_VAL)
+		    return JSON_ERR_BADNUM;
+		if (!validate)
+		    substatus = json_put(jn, &arr->arr.reals.store[slot],
+					 &val, sizeof(val));
+	    }
 	    while (*cp && *cp != '"')
 		cp++;
 	    if (*cp != '"')
@@ -752,39 +2139,67 @@ int json_read_array(const char *cp, const struct json_array_t *arr,
 	    break;
 #endif /* TIME_ENABLE */
 	case t_real:
-	    arr->arr.reals.store[offset] = strtod(cp, &ep);
-	    if (ep == cp)
-		return JSON_ERR_BADNUM;
-	    else
+	    {
+		double val = json_strtod(cp, &ep);
+
+		if (ep == cp)
+		    return JSON_ERR_BADNUM;
 		cp = ep;
+		if (!validate)
+		    substatus = json_put(jn, &arr->arr.reals.store[slot],
+					 &val, sizeof(val));
+	    }
 	    break;
 	case t_boolean:
-	    if (str_starts_with(cp, "true")) {
-		arr->arr.booleans.store[offset] = true;
-		cp += 4;
-	    }
-	    else if (str_starts_with(cp, "false")) {
-		arr->arr.booleans.store[offset] = false;
-		cp += 5;
-	    } else {
-		int val = strtol(cp, &ep, 0);
-		if (ep == cp)
-		    return JSON_ERR_BADNUM;
-		else {
-		    arr->arr.booleans.store[offset] = (bool) val;
-		    cp = ep;
+	case t_bitset:
+	    {
+		bool val;
+
+		if (str_starts_with(cp, "true")) {
+		    val = true;
+		    cp += 4;
 		}
+		else if (str_starts_with(cp, "false")) {
+		    val = false;
+		    cp += 5;
+		} else {
+		    val = (bool)strtol(cp, &ep, 0);
+		    if (ep == cp)
+			return JSON_ERR_BADNUM;
+		    else
+			cp = ep;
+		}
+		if (validate)
+		    ;
+		else if (arr->element_type == t_bitset)
+		    substatus = json_put_bit(jn,
+					     (char *)arr->arr.bitsets.store,
+					     (size_t)slot, val);
+		else
+		    substatus = json_put(jn, &arr->arr.booleans.store[slot],
+					 &val, sizeof(val));
 	    }
 	    break;
 	case t_character:
+	case t_arenastring:
 	case t_array:
 	case t_check:
 	case t_ignore:
 	    json_debug_trace((1, "Invalid array subtype.\n"));
 	    return JSON_ERR_SUBTYPE;
 	}
+	if (substatus != 0)
+	    return substatus;
+      element_done:
+	if (streaming && !validate
+	    && (substatus = arr->callback(arr, offset, arr->arg)) != 0) {
+	    json_debug_trace((1, "Callback stopped the array at %d\n",
+			      offset));
+	    /* negative codes mean something else to json_run_frames() */
+	    return substatus > 0 ? substatus : JSON_ERR_MISC;
+	}
 	arrcount++;
-	if (isspace((unsigned char) *cp))
+	if (json_isspace(*cp))
 	    cp++;
 	if (*cp == ']') {
 	    json_debug_trace((1, "End of array found.\n"));
@@ -801,8 +2216,29 @@ int json_read_array(const char *cp, const struct json_array_t *arr,
 	*end = cp;
     return JSON_ERR_SUBTOOLONG;
   breakout:
-    if (arr->count != NULL)
-	*(arr->count) = arrcount;
+    /* leave no stale bits from a longer array for popcounts to see */
+    substatus = 0;
+    if (arr->element_type == t_bitset && !f->update && !streaming
+	&& !validate)
+	substatus = json_put_clear_bits(jn, (char *)arr->arr.bitsets.store,
+					(size_t)arrcount,
+					(size_t)arr->maxlen);
+    if (substatus != 0)
+	return substatus;
+    /* counts are read back by updates, so they are stored at once */
+    if (arr->count == NULL || validate)
+	;
+    else if (!f->update)
+	substatus = json_put_now(jn, arr->count, &arrcount, sizeof(int));
+    else if ((arr->element_type != t_structobject
+	      || arr->arr.objects.key == NULL) && *(arr->count) < arrcount)
+	/* an update by position only ever extends the array */
+	substatus = json_put_now(jn, arr->count, &arrcount, sizeof(int));
+    if (substatus != 0)
+	return substatus;
+    if (streaming)
+	scratch->streaming--;
+    *cpp = cp;
     if (end != NULL)
 	*end = cp;
     json_debug_trace((1, "leaving json_read_array() with %d elements\n",
@@ -810,16 +2246,1451 @@ int json_read_array(const char *cp, const struct json_array_t *arr,
     return 0;
 }
 
+static int json_run_frames(const char *cp, struct json_frame_t *frames,
+			   int maxdepth, struct json_scratch_t *scratch,
+			   const char **end)
+/* step the frame stack until the outermost frame is finished */
+{
+    struct json_frame_t *f, *child;
+    int depth = 1, status;
+
+    for (;;) {
+	f = &frames[depth - 1];
+	child = depth < maxdepth ? &frames[depth] : NULL;
+	/* only the outermost frame reports an end pointer */
+	if (f->is_array)
+	    status = json_array_step(f, &cp, child, scratch,
+				     depth == 1 ? end : NULL);
+	else
+	    status = json_object_step(f, &cp, child, scratch,
+				      depth == 1 ? end : NULL);
+	if (status == JSON_PUSH)
+	    depth++;
+	else if (status != 0 || --depth == 0)
+	    return status;
+	else
+	    frames[depth - 1].resuming = true;
+    }
+}
+
+static int json_parse_object(const char *cp,
+			     const struct json_attr_t *attrs,
+			     uint64_t *present,
+			     const struct json_options_t *opts,
+			     struct json_frame_t *frames, int maxdepth,
+			     struct json_scratch_t *scratch,
+			     const char **end)
+{
+    struct json_journal_t *jn = opts != NULL ? opts->journal : NULL;
+    int status;
+
+    if (end != NULL)
+	*end = NULL;	/* give it a well-defined value on parse failure */
+    if (maxdepth < 1)
+	return JSON_ERR_DEPTH;
+    if (jn != NULL) {
+	if (jn->buf == NULL)
+	    return JSON_ERR_NULLPTR;
+	jn->used = jn->undo = 0;
+	jn->base = NULL;
+	jn->dflt = jn->dflt_end = jn->dflt_next = 0;
+    }
+    scratch->journal = jn;
+    scratch->streaming = 0;
+    scratch->validate = 0;
+    scratch->limit = NULL;
+    status = json_begin_object(&frames[0], attrs, NULL, 0, present, opts,
+			       opts != NULL && opts->update, scratch);
+    if (status == 0)
+	status = json_run_frames(cp, frames, maxdepth, scratch, end);
+    /* nothing reaches the targets unless the whole parse went through */
+    if (jn != NULL)
+	json_journal_end(jn, status == 0);
+    return status;
+}
+
+static int __attribute__ ((noinline))
+json_builtin_read_object(const char *cp, const struct json_attr_t *attrs,
+			 uint64_t *present,
+			 const struct json_options_t *opts,
+			 struct json_scratch_t *scratch, const char **end)
+/* json_parse_object() on frames of our own, kept out of the caller's */
+{
+    struct json_frame_t frames[JSON_DEPTH_MAX];
+    int maxdepth = JSON_DEPTH_MAX;
+
+    if (opts != NULL && opts->maxdepth > 0 && opts->maxdepth < maxdepth)
+	maxdepth = opts->maxdepth;
+    return json_parse_object(cp, attrs, present, opts, frames, maxdepth,
+			     scratch, end);
+}
+
+static int json_internal_read_object(const char *cp,
+				     const struct json_attr_t *attrs,
+				     uint64_t *present,
+				     const struct json_options_t *opts,
+				     struct json_scratch_t *scratch,
+				     const char **end)
+{
+    if (opts != NULL && opts->frames != NULL)
+	return json_parse_object(cp, attrs, present, opts, opts->frames,
+				 opts->maxdepth, scratch, end);
+    return json_builtin_read_object(cp, attrs, present, opts, scratch, end);
+}
+
+static int json_internal_read_array(const char *cp,
+				    const struct json_array_t *arr,
+				    struct json_scratch_t *scratch,
+				    const char **end)
+{
+    struct json_frame_t frames[JSON_DEPTH_MAX];
+
+    if (end != NULL)
+	*end = NULL;	/* give it a well-defined value on parse failure */
+    json_begin_array(&frames[0], arr, false);
+    scratch->journal = NULL;
+    scratch->streaming = 0;
+    scratch->validate = 0;
+    scratch->limit = NULL;
+    return json_run_frames(cp, frames, JSON_DEPTH_MAX, scratch, end);
+}
+
+int json_read_array(const char *cp, const struct json_array_t *arr,
+		    const char **end)
+{
+    struct json_scratch_t scratch;
+
+    return json_internal_read_array(cp, arr, &scratch, end);
+}
+
 int json_read_object(const char *cp, const struct json_attr_t *attrs,
 		     const char **end)
 {
+    struct json_scratch_t scratch;
     int st;
 
     json_debug_trace((1, "json_read_object() sees '%s'\n", cp));
-    st = json_internal_read_object(cp, attrs, NULL, 0, end);
+    st = json_internal_read_object(cp, attrs, NULL, NULL, &scratch, end);
     return st;
 }
 
+int json_update_object(const char *cp, const struct json_attr_t *attrs,
+		       const char **end)
+/* json_read_object() that writes only what the input supplies */
+{
+    struct json_options_t opts = {.update = true};
+
+    json_debug_trace((1, "json_update_object() sees '%s'\n", cp));
+    return json_read_object_opts(cp, attrs, &opts, end);
+}
+
+int json_validate_object(const char *buf, size_t len,
+			 const struct json_attr_t *attrs)
+/*
+ * Accept or reject the object in the first len bytes of buf by the
+ * rules json_read_object() applies, without converting or storing
+ * anything.  Only whitespace may follow the object.  The object must
+ * close inside the buffer, so a message cut short is refused even
+ * when it is NUL-terminated where it stops.
+ */
+{
+    struct json_scratch_t scratch;
+    struct json_frame_t frames[JSON_DEPTH_MAX];
+    const char *ep = buf + len, *end, *vend, *cp;
+    int status;
+
+    json_debug_trace((1, "json_validate_object() sees '%.*s'\n",
+		      (int)len, buf));
+    cp = json_span_ws(buf, ep);
+    if (cp >= ep || *cp != '{') {
+	json_debug_trace((1, "Non-WS when expecting object start.\n"));
+	return JSON_ERR_OBSTART;
+    }
+    if ((vend = json_span_value(cp, ep)) == NULL) {
+	bool instring = false;
+
+	/* say whether the cut fell inside a string */
+	for (; cp < ep; cp++)
+	    if (instring && *cp == '\\')
+		cp++;
+	    else if (*cp == '"')
+		instring = !instring;
+	json_debug_trace((1, "Object is cut off by the end of the buffer.\n"));
+	return instring ? JSON_ERR_BADSTRING : JSON_ERR_BADTRAIL;
+    }
+    scratch.journal = NULL;
+    scratch.streaming = 0;
+    scratch.validate = 1;
+    scratch.limit = vend;
+    status = json_begin_object(&frames[0], attrs, NULL, 0, NULL,
+			       NULL, false, &scratch);
+    if (status == 0)
+	status = json_run_frames(buf, frames, JSON_DEPTH_MAX, &scratch, &end);
+    if (status != 0)
+	return status;
+    /* the parser must have closed the object the scan found */
+    if (end < vend || json_span_ws(vend, ep) != ep) {
+	json_debug_trace((1, "Object does not fill the message.\n"));
+	return JSON_ERR_BADTRAIL;
+    }
+    return 0;
+}
+
+static uint64_t json_hash(const char *cp, size_t len)
+/* fast non-cryptographic hash, eight bytes at a time */
+{
+    const uint64_t mult = 0x9e3779b97f4a7c15ULL;
+    uint64_t h = len * mult, w;
+
+    for (; len >= 8; cp += 8, len -= 8) {
+	memcpy(&w, cp, sizeof(w));
+	h = (h ^ w) * mult;
+	h ^= h >> 29;
+    }
+    w = 0;
+    memcpy(&w, cp, len);
+    h = (h ^ w) * mult;
+    return h ^ (h >> 32);
+}
+
+int json_read_object_opts(const char *cp, const struct json_attr_t *attrs,
+			  const struct json_options_t *opts,
+			  const char **end)
+{
+    struct json_cache_t *cache = opts != NULL ? opts->cache : NULL;
+    struct json_cache_entry_t *entry = NULL;
+    struct json_scratch_t scratch;
+    size_t len = 0, slot = 0;
+    const char *ep;
+    int st, e = 0;
+
+    json_debug_trace((1, "json_read_object_opts() sees '%s'\n", cp));
+    if (cache != NULL)
+	cache->unchanged = false;
+    if (cache != NULL && cache->nentries > 0 && opts->present == NULL
+	&& opts->required == NULL && opts->select == NULL) {
+	e = (int)(((uintptr_t)attrs >> 4) % (unsigned)cache->nentries);
+	entry = &cache->entries[e];
+	if (cache->text != NULL)
+	    /* each entry owns an equal slice of the text buffer */
+	    slot = cache->textsize / (size_t)cache->nentries;
+	/* only the object last parsed is compared, not what follows it */
+	if (entry->attrs == attrs) {
+	    for (len = 0; len < entry->len && cp[len] != '\0'; len++)
+		continue;
+	    cache->unchanged = len == entry->len
+		&& entry->hash == json_hash(cp, len)
+		&& (cache->text == NULL
+		    || (len <= slot
+			&& memcmp(cache->text + (size_t)e * slot, cp,
+				  len) == 0));
+	}
+	if (cache->unchanged) {
+	    json_debug_trace((1, "Cache hit, targets unchanged\n"));
+	    cache->hits++;
+	    if (end != NULL) {
+		for (ep = cp + len; json_isspace(*ep); ep++)
+		    continue;
+		*end = ep;
+	    }
+	    return 0;
+	}
+	cache->misses++;
+	entry->attrs = NULL;	/* the targets are about to change */
+    }
+    st = json_internal_read_object(cp, attrs,
+				   opts != NULL ? opts->present : NULL,
+				   opts, &scratch, &ep);
+    if (end != NULL)
+	*end = ep;
+    if (st == 0 && entry != NULL) {
+	/* the key is the object itself, without the whitespace after it */
+	for (len = (size_t)(ep - cp); len > 0 && json_isspace(cp[len - 1]);
+	     len--)
+	    continue;
+	if (cache->text == NULL || len <= slot) {
+	    if (cache->text != NULL)
+		memcpy(cache->text + (size_t)e * slot, cp, len);
+	    entry->attrs = attrs;
+	    entry->hash = json_hash(cp, len);
+	    entry->len = len;
+	}
+    }
+    return st;
+}
+
+int json_attr_depth(const struct json_attr_t *attrs)
+/* frames a parse with this template can need, counting its own */
+{
+    const struct json_attr_t *cursor;
+    int depth = 0, sub;
+
+    for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+	if (cursor->type == t_object)
+	    sub = json_attr_depth(cursor->addr.attrs);
+	else if (cursor->type != t_array)
+	    sub = 0;
+	else if (cursor->addr.array.element_type == t_object
+		 || cursor->addr.array.element_type == t_structobject
+		 || cursor->addr.array.element_type == t_columnobject)
+	    sub = 1 + json_attr_depth(cursor->addr.array.arr.objects.subtype);
+	else
+	    sub = 1;
+	if (sub > depth)
+	    depth = sub;
+    }
+    return depth + 1;
+}
+
+/*
+ * Structural index.
+ *
+ * json_index() lexes a JSON value once and records the kind and byte
+ * extent of every token in a caller-supplied array.  Containers come
+ * before their contents, and each token's next field is the index of
+ * the token following the whole value, so a binder can step over a
+ * member without looking inside it.  json_tokenize() is the same lexer
+ * made resumable: when the array fills up it keeps its place in the
+ * index structure and carries on when called again with more room.
+ * json_read_object_index() then binds a template from the index alone,
+ * as often as needed, without lexing the text again.
+ */
+
+static int json_index_push(struct json_index_t *ix, json_tokkind kind,
+			   const char *cp, int parent)
+/* append a token, returning its index or -1 if the index is full */
+{
+    struct json_token_t *tok;
+
+    if (ix->ntokens >= ix->maxtokens)
+	return -1;
+    tok = &ix->tokens[ix->ntokens];
+    tok->kind = kind;
+    tok->start = (int)(cp - ix->buf);
+    tok->end = tok->start;
+    tok->next = ix->ntokens + 1;
+    tok->parent = parent;
+    return ix->ntokens++;
+}
+
+int json_tokenize(const char *buf, struct json_index_t *ix, const char **end)
+{
+    enum
+    { want_value, first_value, want_key, first_key, want_colon, want_comma
+    } expect;
+    const char *cp;
+    int t, open;	/* innermost container not yet closed */
+
+    if (end != NULL)
+	*end = NULL;	/* give it a well-defined value on parse failure */
+    if (ix->ntokens == 0) {
+	ix->pos = 0;
+	ix->open = -1;
+	ix->expect = want_value;
+    }
+    /* pick up where the last call ran out of tokens, if it did */
+    ix->buf = buf;
+    ix->complete = false;
+    cp = buf + ix->pos;
+    open = ix->open;
+    expect = ix->expect;
+
+    for (;;) {
+	while (json_isspace(*cp))
+	    cp++;
+	switch (expect) {
+	case want_colon:
+	    if (*cp != ':') {
+		json_debug_trace((1, "Missing colon after attribute name\n"));
+		return JSON_ERR_BADTRAIL;
+	    }
+	    cp++;
+	    expect = want_value;
+	    continue;
+	case want_comma:
+	    if (open < 0)
+		goto done;
+	    if (*cp == ',') {
+		cp++;
+		expect = ix->tokens[open].kind == tok_object
+		    ? want_key : want_value;
+		continue;
+	    }
+	    if (*cp != (ix->tokens[open].kind == tok_object ? '}' : ']')) {
+		json_debug_trace((1, "Garbage while expecting comma or close\n"));
+		if (end != NULL)
+		    *end = cp;
+		return JSON_ERR_BADTRAIL;
+	    }
+	    break;	/* close the container below */
+	case first_key:
+	    if (*cp == '}')
+		break;
+	    __attribute__ ((fallthrough));
+	case want_key:
+	    if (*cp != '"') {
+		json_debug_trace((1, "Non-WS when expecting attribute\n"));
+		if (end != NULL)
+		    *end = cp;
+		return JSON_ERR_ATTRSTART;
+	    }
+	    __attribute__ ((fallthrough));
+	case first_value:
+	    if (expect == first_value && *cp == ']')
+		break;
+	    __attribute__ ((fallthrough));
+	case want_value:
+	    if (*cp == '{' || *cp == '[') {
+		t = json_index_push(ix, *cp == '{' ? tok_object : tok_array,
+				    cp, open);
+		if (t < 0)
+		    goto full;
+		open = t;
+		expect = *cp == '{' ? first_key : first_value;
+		cp++;
+	    } else if (*cp == '"') {
+		t = json_index_push(ix, tok_string, cp + 1, open);
+		if (t < 0)
+		    goto full;
+		cp++;
+		for (;;) {
+		    cp += strcspn(cp, "\"\\");
+		    if (*cp != '\\' || cp[1] == '\0')
+			break;
+		    cp += 2;
+		}
+		if (*cp != '"') {
+		    json_debug_trace((1, "Unterminated string\n"));
+		    return JSON_ERR_BADSTRING;
+		}
+		ix->tokens[t].end = (int)(cp - ix->buf);
+		cp++;
+		expect = expect == want_key || expect == first_key
+		    ? want_colon : want_comma;
+	    } else if (*cp == '\0' || strchr(",:]}", *cp) != NULL) {
+		json_debug_trace((1, "Missing value\n"));
+		if (end != NULL)
+		    *end = cp;
+		return JSON_ERR_BADTRAIL;
+	    } else {
+		t = json_index_push(ix, tok_bare, cp, open);
+		if (t < 0)
+		    goto full;
+		while (*cp != '\0' && !json_isspace(*cp)
+		       && strchr(",:]}", *cp) == NULL)
+		    cp++;
+		ix->tokens[t].end = (int)(cp - ix->buf);
+		expect = want_comma;
+	    }
+	    continue;
+	}
+	/* *cp closes the innermost open container */
+	t = open;
+	open = ix->tokens[t].parent;
+	ix->tokens[t].next = ix->ntokens;
+	ix->tokens[t].end = (int)(++cp - ix->buf);
+	expect = want_comma;
+    }
+
+  done:
+    ix->pos = (int)(cp - buf);
+    ix->open = open;
+    ix->expect = expect;
+    ix->complete = true;
+    if (end != NULL)
+	*end = cp;
+    json_debug_trace((1, "Indexed %d tokens\n", ix->ntokens));
+    return 0;
+
+  full:
+    /* save the lexer state so a call with more room can carry on */
+    ix->pos = (int)(cp - buf);
+    ix->open = open;
+    ix->expect = expect;
+    json_debug_trace((1, "Token array full after %d tokens\n",
+		      ix->ntokens));
+    return JSON_ERR_INDEXFULL;
+}
+
+int json_index(const char *cp, struct json_index_t *ix, const char **end)
+{
+    ix->ntokens = 0;
+    return json_tokenize(cp, ix, end);
+}
+
+static int json_bind_object(const struct json_index_t *ix, int t,
+			    const struct json_attr_t *attrs,
+			    const struct json_array_t *parent, int offset,
+			    uint64_t *present, struct json_scratch_t *scratch);
+
+static int json_bind_array(const struct json_index_t *ix, int t,
+			   const struct json_array_t *arr,
+			   struct json_scratch_t *scratch)
+{
+    const struct json_token_t *tok = ix->tokens;
+    size_t presentwords = 0;
+    int e, n, slot, substatus;
+
+    if (arr->element_type != t_object && arr->element_type != t_structobject
+	&& arr->element_type != t_columnobject)
+	/* scalar conversion has to read the element text anyway */
+	return json_internal_read_array(ix->buf + tok[t].start, arr,
+				       scratch, NULL);
+
+    if (arr->arr.objects.present != NULL)
+	presentwords =
+	    JSON_BITSET_WORDS(json_attr_count(arr->arr.objects.subtype));
+    for (e = t + 1, n = 0; e < tok[t].next; e = tok[e].next, n++) {
+	if (n >= arr->maxlen && arr->callback == NULL) {
+	    json_debug_trace((1, "Too many elements in array.\n"));
+	    return JSON_ERR_SUBTOOLONG;
+	}
+	slot = arr->callback != NULL ? 0 : n;
+	substatus = json_bind_object(ix, e, arr->arr.objects.subtype, arr,
+				     slot,
+				     presentwords > 0
+				     ? arr->arr.objects.present
+				     + slot * presentwords : NULL, scratch);
+	if (substatus == 0 && arr->callback != NULL
+	    && (substatus = arr->callback(arr, n, arr->arg)) < 0)
+	    substatus = JSON_ERR_MISC;
+	if (substatus != 0)
+	    return substatus;
+    }
+    if (arr->count != NULL)
+	*(arr->count) = n;
+    return 0;
+}
+
+static int json_bind_object(const struct json_index_t *ix, int t,
+			    const struct json_attr_t *attrs,
+			    const struct json_array_t *parent, int offset,
+			    uint64_t *present, struct json_scratch_t *scratch)
+{
+    const struct json_token_t *tok = ix->tokens;
+    char *const attrbuf = scratch->attrbuf;
+    char *const valbuf = scratch->valbuf;
+    const struct json_attr_t *cursor;
+    const char *cp, *kp;
+    size_t klen;
+    int k, v, len, maxlen, substatus;
+
+    if (tok[t].kind != tok_object) {
+	json_debug_trace((1, "Indexed value is not an object\n"));
+	return JSON_ERR_OBSTART;
+    }
+    if (present != NULL)
+	memset(present, '\0',
+	       JSON_BITSET_WORDS(json_attr_count(attrs)) * sizeof(uint64_t));
+    substatus = json_apply_defaults(attrs, parent, offset, NULL, NULL);
+    if (substatus != 0)
+	return substatus;
+
+    for (k = t + 1; k < tok[t].next; k = tok[v].next) {
+	v = k + 1;
+	kp = ix->buf + tok[k].start;
+	klen = (size_t)(tok[k].end - tok[k].start);
+	if (memchr(kp, '\\', klen) != NULL) {
+	    /* escaped name: decode it first */
+	    cp = kp;
+	    substatus = json_read_string(&cp, attrbuf, JSON_ATTR_MAX - 1,
+					 &klen);
+	    if (substatus == JSON_ERR_STRLONG) {
+		json_debug_trace((1, "Escaped attribute name too long.\n"));
+		return JSON_ERR_ATTRLEN;
+	    } else if (substatus != 0)
+		return substatus;
+	    kp = attrbuf;
+	}
+	cursor = json_find_attr(attrs, kp, klen);
+	if (cursor == NULL) {
+	    json_debug_trace((1, "Unknown attribute name '%.*s'.\n",
+			      (int)klen, kp));
+	    return JSON_ERR_BADATTR;
+	}
+	if (tok[v].kind == tok_array) {
+	    if (cursor->type != t_array)
+		return JSON_ERR_NOARRAY;
+	    substatus = json_bind_array(ix, v, &cursor->addr.array, scratch);
+	} else if (cursor->type == t_array)
+	    return JSON_ERR_NOBRAK;
+	else if (tok[v].kind == tok_object) {
+	    if (cursor->type != t_object)
+		return JSON_ERR_NOARRAY;
+	    substatus = json_bind_object(ix, v, cursor->addr.attrs,
+					 NULL, 0, NULL, scratch);
+	} else if (cursor->type == t_object)
+	    return JSON_ERR_NOCURLY;
+	else if (tok[v].kind == tok_string) {
+	    maxlen = json_value_maxlen(cursor);
+	    cp = ix->buf + tok[v].start;
+	    substatus = json_read_string(&cp, valbuf,
+					 maxlen < JSON_VAL_MAX - 1
+					 ? (size_t)(maxlen + 1)
+					 : JSON_VAL_MAX, NULL);
+	    if (substatus == 0)
+		substatus = json_store_value(&cursor, parent, offset,
+					     valbuf, val_string, NULL);
+	} else {
+	    len = tok[v].end - tok[v].start;
+	    if (len > JSON_VAL_MAX) {
+		json_debug_trace((1, "Token value too long.\n"));
+		return JSON_ERR_TOKLONG;
+	    }
+	    memcpy(valbuf, ix->buf + tok[v].start, (size_t)len);
+	    valbuf[len] = '\0';
+	    substatus = json_store_value(&cursor, parent, offset,
+					 valbuf, json_scan_kind(valbuf), NULL);
+	}
+	if (substatus != 0)
+	    return substatus;
+	json_mark_present(present, attrs, cursor);
+    }
+    return 0;
+}
+
+int json_read_object_index(const struct json_index_t *ix,
+			   const struct json_attr_t *attrs)
+{
+    struct json_scratch_t scratch;
+
+    json_debug_trace((1, "json_read_object_index() sees %d tokens\n",
+		      ix->ntokens));
+    if (ix->ntokens == 0)
+	return JSON_ERR_OBSTART;
+    if (!ix->complete) {
+	/* the lexer stopped early; the tokens don't describe the message */
+	json_debug_trace((1, "Index is incomplete\n"));
+	return JSON_ERR_INDEXFULL;
+    }
+    return json_bind_object(ix, 0, attrs, NULL, 0, NULL, &scratch);
+}
+
+/*
+ * Template compiler.
+ *
+ * json_jit_compile() turns a flat template into x86-64 machine code in
+ * an mmap(2)ed region, for programs that only learn their templates at
+ * run time but parse with them for a long while.  Three routines are
+ * emitted.  match(kp, klen) compares the key against each attribute
+ * name with a length test and immediate 8/4/2/1-byte compares and
+ * returns the template index, or that of the wildcard.  store(i, v)
+ * makes the quoted/unquoted check for entry i, converts the value with
+ * the same library calls json_store_value() uses and stores the result
+ * straight to the target's absolute address.  defaults() writes every
+ * default as an immediate.  Lexing stays in C, in json_jit_read().
+ *
+ * Only scalar, string, check and ignore entries with fixed addresses
+ * are compiled.  Anything else (maps, arrays, sub-objects, times,
+ * bitsets, several type specs for one name) leaves code NULL and the
+ * interpreter does the work.  The compiler is built only on Linux
+ * x86-64 with JIT_ENABLE defined.
+ */
+
+/* a collected value, laid out as the generated code expects */
+struct json_jit_value {
+    const char *text;	/* valbuf if quoted, else the token in place */
+    size_t len;
+    bool quoted;
+};
+
+static int json_jit_collect(const char **cpp, char *valbuf, size_t size,
+			    struct json_jit_value *val)
+/* collect one scalar value as the interpreter would */
+{
+    const char *cp = *cpp;
+    int status;
+
+    while (json_isspace(*cp) || *cp == ':')
+	cp++;
+    if (*cp == '[' || *cp == '{') {
+	json_debug_trace((1, "Saw %c when not expecting one.\n", *cp));
+	return JSON_ERR_NOARRAY;
+    }
+    if (*cp == '"') {
+	++cp;
+	status = json_read_string(&cp, valbuf, size, NULL);
+	if (status != 0)
+	    return status;
+	val->text = valbuf;
+	val->len = strlen(valbuf);	/* \u0000 ends it, as in the interpreter */
+	val->quoted = true;
+    } else {
+	val->text = cp;
+	while (*cp != '\0' && !json_isspace(*cp)
+	       && *cp != ',' && *cp != '}')
+	    cp++;
+	val->len = (size_t)(cp - val->text);
+	if (val->len > JSON_VAL_MAX) {
+	    json_debug_trace((1, "Token value too long.\n"));
+	    return JSON_ERR_TOKLONG;
+	}
+	val->quoted = false;
+    }
+    *cpp = cp;
+    return 0;
+}
+
+int json_jit_read(const struct json_jit_t *jit, const char *cp,
+		  const char **end)
+{
+    char valbuf[JSON_VAL_MAX + 1], keybuf[JSON_ATTR_MAX + 1];
+    struct json_jit_value val;
+    const char *kp;
+    size_t klen, size;
+    int f, maxlen, status;
+
+    if (jit->code == NULL)
+	return json_read_object(cp, jit->attrs, end);
+    json_debug_trace((1, "json_jit_read() sees '%s'\n", cp));
+    if (end != NULL)
+	*end = NULL;
+    jit->defaults();
+
+    while (json_isspace(*cp))
+	cp++;
+    if (*cp != '{') {
+	json_debug_trace((1, "Non-WS when expecting object start.\n"));
+	if (end != NULL)
+	    *end = cp;
+	return JSON_ERR_OBSTART;
+    }
+    for (cp++;;) {
+	while (json_isspace(*cp))
+	    cp++;
+	if (*cp == '}')
+	    break;
+	if (*cp != '"') {
+	    json_debug_trace((1, "Non-WS when expecting attribute.\n"));
+	    if (end != NULL)
+		*end = cp;
+	    return JSON_ERR_ATTRSTART;
+	}
+	kp = ++cp;
+	cp += strcspn(cp, "\"\\");
+	if (*cp == '\0')
+	    return JSON_ERR_BADTRAIL;
+	else if (*cp == '"')
+	    klen = (size_t)(cp++ - kp);
+	else {
+	    /* an escaped name is decoded, as json_object_step() does */
+	    cp = kp;
+	    status = json_read_string(&cp, keybuf, JSON_ATTR_MAX - 1, &klen);
+	    if (status == JSON_ERR_STRLONG)
+		return JSON_ERR_ATTRLEN;
+	    else if (status != 0)
+		return status;
+	    kp = keybuf;
+	}
+	f = jit->match(kp, klen);
+	if (f < 0) {
+	    json_debug_trace((1, "Unknown attribute name '%.*s'.\n",
+			      (int)klen, kp));
+	    return JSON_ERR_BADATTR;
+	}
+	maxlen = json_value_maxlen(&jit->attrs[f]);
+	size = maxlen < JSON_VAL_MAX - 1 ? (size_t)maxlen + 1 : JSON_VAL_MAX;
+	status = json_jit_collect(&cp, valbuf, size, &val);
+	if (status == 0)
+	    status = jit->store(f, &val);
+	if (status != 0)
+	    return status;
+
+	while (json_isspace(*cp))
+	    cp++;
+	if (*cp == '}')
+	    break;
+	if (*cp != ',') {
+	    json_debug_trace((1, "Garbage while expecting comma or }.\n"));
+	    if (end != NULL)
+		*end = cp;
+	    return JSON_ERR_BADTRAIL;
+	}
+	cp++;
+    }
+
+    /* in case there's another object following, consume trailing WS */
+    for (cp++; json_isspace(*cp); cp++)
+	continue;
+    if (end != NULL)
+	*end = cp;
+    return 0;
+}
+
+#ifdef JSON_JIT_X86_64
+struct json_jit_buf {
+    unsigned char *base, *p, *end;
+    bool overflow;
+};
+
+/* emit an instruction given as a string literal of opcode bytes */
+#define JIT_OP(b, s)	json_jit_bytes(b, s, sizeof(s) - 1)
+
+#define JIT_JE		"\x0F\x84"
+#define JIT_JNE		"\x0F\x85"
+#define JIT_JBE		"\x0F\x86"
+#define JIT_JMP		"\xE9"
+
+static void json_jit_bytes(struct json_jit_buf *b, const void *src, size_t n)
+{
+    if ((size_t)(b->end - b->p) < n) {
+	b->overflow = true;
+	return;
+    }
+    memcpy(b->p, src, n);
+    b->p += n;
+}
+
+static void json_jit_imm8(struct json_jit_buf *b, unsigned char v)
+{
+    json_jit_bytes(b, &v, sizeof(v));
+}
+
+static void json_jit_imm32(struct json_jit_buf *b, uint32_t v)
+{
+    json_jit_bytes(b, &v, sizeof(v));
+}
+
+static void json_jit_imm64(struct json_jit_buf *b, uint64_t v)
+{
+    json_jit_bytes(b, &v, sizeof(v));
+}
+
+static size_t json_jit_here(const struct json_jit_buf *b)
+{
+    return (size_t)(b->p - b->base);
+}
+
+static size_t json_jit_jump(struct json_jit_buf *b, const char *op,
+			    size_t oplen)
+/* emit a jump with its rel32 left open; returns where to patch it */
+{
+    json_jit_bytes(b, op, oplen);
+    json_jit_imm32(b, 0);
+    return json_jit_here(b) - 4;
+}
+
+static void json_jit_patch(struct json_jit_buf *b, size_t at)
+/* point the jump whose rel32 is at offset at here */
+{
+    uint32_t rel = (uint32_t)(json_jit_here(b) - (at + 4));
+
+    if (!b->overflow)
+	memcpy(b->base + at, &rel, sizeof(rel));
+}
+
+static void json_jit_jump_to(struct json_jit_buf *b, const char *op,
+			     size_t oplen, size_t target)
+/* emit a jump to an offset already emitted */
+{
+    json_jit_bytes(b, op, oplen);
+    json_jit_imm32(b, (uint32_t)(target - (json_jit_here(b) + 4)));
+}
+
+#define JIT_JUMP(b, op)		json_jit_jump(b, op, sizeof(op) - 1)
+#define JIT_JUMP_TO(b, op, t)	json_jit_jump_to(b, op, sizeof(op) - 1, t)
+
+static void json_jit_call(struct json_jit_buf *b, const void *fn)
+{
+    JIT_OP(b, "\x48\xB8");		/* mov rax, fn */
+    json_jit_imm64(b, (uint64_t)(uintptr_t)fn);
+    JIT_OP(b, "\xFF\xD0");		/* call rax */
+}
+
+static void json_jit_target(struct json_jit_buf *b,
+			    const struct json_attr_t *cursor)
+{
+    JIT_OP(b, "\x48\xB9");		/* mov rcx, target */
+    json_jit_imm64(b, (uint64_t)(uintptr_t)
+		   json_target_address(cursor, NULL, 0));
+}
+
+static void json_jit_fail(struct json_jit_buf *b, int status, size_t epilogue)
+{
+    JIT_OP(b, "\xB8");			/* mov eax, status */
+    json_jit_imm32(b, (uint32_t)status);
+    JIT_JUMP_TO(b, JIT_JMP, epilogue);
+}
+
+static int json_jit_boolean(const struct json_jit_value *val)
+{
+    return (val->len == 4 && memcmp(val->text, "true", 4) == 0)
+	|| strtol(val->text, NULL, 0) != 0;
+}
+
+static void json_jit_string(const struct json_jit_value *val, char *lptr,
+			    size_t cl)
+{
+    memset(lptr, '\0', cl + 1);
+    memcpy(lptr, val->text, val->len < cl ? val->len : cl);
+}
+
+static bool json_jit_supported(const struct json_attr_t *attrs)
+/* can every entry be compiled? */
+{
+    const struct json_attr_t *cursor, *other;
+
+    for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+	if (cursor->map != NULL
+	    || strlen(cursor->attribute) > JSON_ATTR_MAX - 1)
+	    return false;
+	for (other = attrs; other < cursor; other++)
+	    if (strcmp(other->attribute, cursor->attribute) == 0)
+		return false;
+	switch (cursor->type) {
+	case t_integer:
+	case t_uinteger:
+	case t_short:
+	case t_ushort:
+	case t_real:
+	case t_boolean:
+	case t_character:
+	case t_string:
+	    if (json_target_address(cursor, NULL, 0) == NULL)
+		return false;
+	    break;
+	case t_check:
+	    if (cursor->dflt.check == NULL)
+		return false;
+	    break;
+	case t_ignore:
+	    break;
+	default:
+	    return false;
+	}
+    }
+    return true;
+}
+
+static void json_jit_emit_match(struct json_jit_buf *b,
+				const struct json_attr_t *attrs)
+/* int match(const char *kp [rdi], size_t klen [rsi]) */
+{
+    const struct json_attr_t *cursor;
+    size_t misses[JSON_ATTR_MAX], nmiss, len, off, n, i;
+    int found = -1;
+    uint64_t word;
+
+    for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+	if (cursor->attribute[0] == '\0' && cursor->type == t_ignore) {
+	    /* json_find_attr() never looks past a wildcard */
+	    found = (int)(cursor - attrs);
+	    break;
+	}
+	len = strlen(cursor->attribute);
+	nmiss = 0;
+	JIT_OP(b, "\x48\x81\xFE");	/* cmp rsi, len */
+	json_jit_imm32(b, (uint32_t)len);
+	misses[nmiss++] = JIT_JUMP(b, JIT_JNE);
+	for (off = 0; off < len; off += n) {
+	    n = len - off >= 8 ? 8 : len - off >= 4 ? 4 : len - off >= 2 ? 2 : 1;
+	    word = 0;
+	    memcpy(&word, cursor->attribute + off, n);
+	    switch (n) {
+	    case 8:
+		JIT_OP(b, "\x48\x8B\x87");	/* mov rax, [rdi+off] */
+		json_jit_imm32(b, (uint32_t)off);
+		JIT_OP(b, "\x48\xB9");		/* mov rcx, word */
+		json_jit_imm64(b, word);
+		JIT_OP(b, "\x48\x39\xC8");	/* cmp rax, rcx */
+		break;
+	    case 4:
+		JIT_OP(b, "\x8B\x87");		/* mov eax, [rdi+off] */
+		break;
+	    case 2:
+		JIT_OP(b, "\x0F\xB7\x87");	/* movzx eax, word [rdi+off] */
+		break;
+	    default:
+		JIT_OP(b, "\x0F\xB6\x87");	/* movzx eax, byte [rdi+off] */
+		break;
+	    }
+	    if (n < 8) {
+		json_jit_imm32(b, (uint32_t)off);
+		JIT_OP(b, "\x3D");		/* cmp eax, word */
+		json_jit_imm32(b, (uint32_t)word);
+	    }
+	    misses[nmiss++] = JIT_JUMP(b, JIT_JNE);
+	}
+	JIT_OP(b, "\xB8");			/* mov eax, index */
+	json_jit_imm32(b, (uint32_t)(cursor - attrs));
+	JIT_OP(b, "\xC3");			/* ret */
+	for (i = 0; i < nmiss; i++)
+	    json_jit_patch(b, misses[i]);
+    }
+    JIT_OP(b, "\xB8");				/* mov eax, found */
+    json_jit_imm32(b, (uint32_t)found);
+    JIT_OP(b, "\xC3");				/* ret */
+}
+
+static void json_jit_emit_field(struct json_jit_buf *b,
+				const struct json_attr_t *cursor,
+				size_t epilogue)
+/* store code for one entry; rbx holds the json_jit_value */
+{
+    size_t ok;
+
+    switch (cursor->type) {
+    case t_string:
+    case t_check:
+    case t_ignore:
+    case t_character:
+	break;
+    default:
+	JIT_OP(b, "\x0F\xB6\x43");	/* movzx eax, byte [rbx+quoted] */
+	json_jit_imm8(b, offsetof(struct json_jit_value, quoted));
+	JIT_OP(b, "\x85\xC0");		/* test eax, eax */
+	ok = JIT_JUMP(b, JIT_JE);
+	json_jit_fail(b, JSON_ERR_QNONSTRING, epilogue);
+	json_jit_patch(b, ok);
+	break;
+    }
+    if (cursor->type == t_string || cursor->type == t_check) {
+	JIT_OP(b, "\x0F\xB6\x43");	/* movzx eax, byte [rbx+quoted] */
+	json_jit_imm8(b, offsetof(struct json_jit_value, quoted));
+	JIT_OP(b, "\x85\xC0");		/* test eax, eax */
+	ok = JIT_JUMP(b, JIT_JNE);
+	json_jit_fail(b, JSON_ERR_NONQSTRING, epilogue);
+	json_jit_patch(b, ok);
+    }
+
+    switch (cursor->type) {
+    case t_integer:
+    case t_uinteger:
+    case t_short:
+    case t_ushort:
+	/* atoi(), as json_store_value() does */
+	JIT_OP(b, "\x48\x8B\x3B");	/* mov rdi, [rbx+text] */
+	JIT_OP(b, "\x31\xF6");		/* xor esi, esi */
+	JIT_OP(b, "\xBA");		/* mov edx, 10 */
+	json_jit_imm32(b, 10);
+	json_jit_call(b, (const void *)strtol);
+	json_jit_target(b, cursor);
+	if (cursor->type == t_short || cursor->type == t_ushort)
+	    JIT_OP(b, "\x66\x89\x01");	/* mov [rcx], ax */
+	else
+	    JIT_OP(b, "\x89\x01");	/* mov [rcx], eax */
+	break;
+    case t_real:
+	JIT_OP(b, "\x48\x8B\x3B");	/* mov rdi, [rbx+text] */
+	JIT_OP(b, "\x31\xF6");		/* xor esi, esi */
+	json_jit_call(b, (const void *)json_strtod);
+	json_jit_target(b, cursor);
+	JIT_OP(b, "\xF2\x0F\x11\x01");	/* movsd [rcx], xmm0 */
+	break;
+    case t_boolean:
+	JIT_OP(b, "\x48\x89\xDF");	/* mov rdi, rbx */
+	json_jit_call(b, (const void *)json_jit_boolean);
+	json_jit_target(b, cursor);
+	JIT_OP(b, "\x88\x01");		/* mov [rcx], al */
+	break;
+    case t_character:
+	JIT_OP(b, "\x48\x8B\x43");	/* mov rax, [rbx+len] */
+	json_jit_imm8(b, offsetof(struct json_jit_value, len));
+	JIT_OP(b, "\x48\x83\xF8\x01");	/* cmp rax, 1 */
+	ok = JIT_JUMP(b, JIT_JBE);
+	json_jit_fail(b, JSON_ERR_STRLONG, epilogue);
+	json_jit_patch(b, ok);
+	JIT_OP(b, "\x31\xD2");		/* xor edx, edx */
+	JIT_OP(b, "\x48\x85\xC0");	/* test rax, rax */
+	ok = JIT_JUMP(b, JIT_JE);
+	JIT_OP(b, "\x48\x8B\x0B");	/* mov rcx, [rbx+text] */
+	JIT_OP(b, "\x0F\xB6\x11");	/* movzx edx, byte [rcx] */
+	json_jit_patch(b, ok);
+	json_jit_target(b, cursor);
+	JIT_OP(b, "\x88\x11");		/* mov [rcx], dl */
+	break;
+    case t_string:
+	JIT_OP(b, "\x48\x89\xDF");	/* mov rdi, rbx */
+	JIT_OP(b, "\x48\xBE");		/* mov rsi, target */
+	json_jit_imm64(b, (uint64_t)(uintptr_t)cursor->addr.string);
+	JIT_OP(b, "\xBA");		/* mov edx, len - 1 */
+	json_jit_imm32(b, (uint32_t)(cursor->len - 1));
+	json_jit_call(b, (const void *)json_jit_string);
+	break;
+    case t_check:
+	JIT_OP(b, "\x48\x8B\x3B");	/* mov rdi, [rbx+text] */
+	JIT_OP(b, "\x48\xBE");		/* mov rsi, check */
+	json_jit_imm64(b, (uint64_t)(uintptr_t)cursor->dflt.check);
+	json_jit_call(b, (const void *)strcmp);
+	JIT_OP(b, "\x85\xC0");		/* test eax, eax */
+	ok = JIT_JUMP(b, JIT_JE);
+	json_jit_fail(b, JSON_ERR_CHECKFAIL, epilogue);
+	json_jit_patch(b, ok);
+	break;
+    default:
+	break;
+    }
+    JIT_OP(b, "\x31\xC0");		/* xor eax, eax */
+    JIT_JUMP_TO(b, JIT_JMP, epilogue);
+}
+
+static void json_jit_emit_store(struct json_jit_buf *b,
+				const struct json_attr_t *attrs,
+				size_t *fields)
+/* int store(int f [edi], const struct json_jit_value *val [rsi]) */
+{
+    const struct json_attr_t *cursor;
+    size_t dispatch, epilogue;
+
+    JIT_OP(b, "\x53");			/* push rbx, aligning the stack */
+    JIT_OP(b, "\x48\x89\xF3");		/* mov rbx, rsi */
+    dispatch = JIT_JUMP(b, JIT_JMP);
+    epilogue = json_jit_here(b);
+    JIT_OP(b, "\x5B");			/* pop rbx */
+    JIT_OP(b, "\xC3");			/* ret */
+    for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+	fields[cursor - attrs] = json_jit_here(b);
+	json_jit_emit_field(b, cursor, epilogue);
+    }
+    json_jit_patch(b, dispatch);
+    for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+	JIT_OP(b, "\x81\xFF");		/* cmp edi, f */
+	json_jit_imm32(b, (uint32_t)(cursor - attrs));
+	JIT_JUMP_TO(b, JIT_JE, fields[cursor - attrs]);
+    }
+    json_jit_fail(b, JSON_ERR_BADATTR, epilogue);
+}
+
+static void json_jit_emit_defaults(struct json_jit_buf *b,
+				   const struct json_attr_t *attrs)
+/* void defaults(void), the compiled json_apply_defaults() */
+{
+    const struct json_attr_t *cursor;
+
+    for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+	if (cursor->nodefault || cursor->type == t_check
+	    || cursor->type == t_ignore)
+	    continue;
+	json_jit_target(b, cursor);
+	switch (cursor->type) {
+	case t_integer:
+	case t_uinteger:
+	    JIT_OP(b, "\xC7\x01");		/* mov dword [rcx], imm */
+	    json_jit_imm32(b, (uint32_t)cursor->dflt.integer);
+	    break;
+	case t_short:
+	case t_ushort:
+	    JIT_OP(b, "\x66\xC7\x01");	/* mov word [rcx], imm */
+	    json_jit_bytes(b, &cursor->dflt.ushortint, 2);
+	    break;
+	case t_real:
+	    JIT_OP(b, "\x48\xB8");		/* mov rax, imm */
+	    json_jit_bytes(b, &cursor->dflt.real, 8);
+	    JIT_OP(b, "\x48\x89\x01");	/* mov [rcx], rax */
+	    break;
+	case t_boolean:
+	    JIT_OP(b, "\xC6\x01");		/* mov byte [rcx], imm */
+	    json_jit_imm8(b, cursor->dflt.boolean);
+	    break;
+	case t_character:
+	    JIT_OP(b, "\xC6\x01");		/* mov byte [rcx], imm */
+	    json_jit_imm8(b, (unsigned char)cursor->dflt.character);
+	    break;
+	default:			/* t_string */
+	    JIT_OP(b, "\xC6\x01\x00");	/* mov byte [rcx], 0 */
+	    break;
+	}
+    }
+    JIT_OP(b, "\xC3");			/* ret */
+}
+#endif /* JSON_JIT_X86_64 */
+
+bool json_jit_compile(const struct json_attr_t *attrs, struct json_jit_t *jit)
+/* compile a template; false means json_jit_read() will interpret it */
+{
+#ifdef JSON_JIT_X86_64
+    struct json_jit_buf b;
+    size_t fields[JSON_JIT_MAXATTRS], store, defaults, n;
+    void *base;
+#endif /* JSON_JIT_X86_64 */
+
+    memset(jit, '\0', sizeof(*jit));
+    jit->attrs = attrs;
+#ifdef JSON_JIT_X86_64
+    n = json_attr_count(attrs);
+    if (n > JSON_JIT_MAXATTRS || !json_jit_supported(attrs)) {
+	json_debug_trace((1, "Template not compiled, interpreting it.\n"));
+	return false;
+    }
+    jit->codesize = 64 + (n + 1) * 320;	/* generous worst case */
+    base = mmap(NULL, jit->codesize, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+	return false;
+    b.base = b.p = base;
+    b.end = b.base + jit->codesize;
+    b.overflow = false;
+    json_jit_emit_match(&b, attrs);
+    store = json_jit_here(&b);
+    json_jit_emit_store(&b, attrs, fields);
+    defaults = json_jit_here(&b);
+    json_jit_emit_defaults(&b, attrs);
+    /* never writable and executable at once */
+    if (b.overflow
+	|| mprotect(base, jit->codesize, PROT_READ | PROT_EXEC) != 0) {
+	(void)munmap(base, jit->codesize);
+	jit->codesize = 0;
+	return false;
+    }
+    jit->code = base;
+    jit->match = (int (*)(const char *, size_t))(uintptr_t)b.base;
+    jit->store = (int (*)(int, const void *))(uintptr_t)(b.base + store);
+    jit->defaults = (void (*)(void))(uintptr_t)(b.base + defaults);
+    json_debug_trace((1, "Compiled %zu entries into %zu bytes.\n",
+		      n, json_jit_here(&b)));
+    return true;
+#else
+    json_debug_trace((1, "No template compiler in this build.\n"));
+    return false;
+#endif /* JSON_JIT_X86_64 */
+}
+
+void json_jit_free(struct json_jit_t *jit)
+{
+#ifdef JSON_JIT_X86_64
+    if (jit->code != NULL)
+	(void)munmap(jit->code, jit->codesize);
+#endif /* JSON_JIT_X86_64 */
+    jit->code = NULL;
+}
+
+/*
+ * Template-free path queries.
+ *
+ * The json_get_*() functions pull one value out of a buffer of known
+ * length without a template.  A path is a sequence of member names
+ * separated by dots, each optionally followed by [n] array subscripts,
+ * as in "devices[0].path".  The walk steps over everything it does not
+ * need without interpreting it, stops as soon as the value is found,
+ * and never reads past the end of the buffer.  Only the addressed value
+ * is converted, using the same converters as the template parser.
+ */
+
+static int json_get_span(const char *buf, size_t len, const char *path,
+			 const char **vp, const char **vend)
+/* find the value path addresses, setting [*vp, *vend) to its text */
+{
+    const char *cp = buf, *ep = buf + len;
+
+    while (*path != '\0') {
+	cp = json_span_ws(cp, ep);
+	if (*path == '[') {
+	    const char *pe = path + 1;
+	    long index = 0;
+
+	    /* digits only: no sign, no whitespace */
+	    for (; json_isdigit(*pe); pe++) {
+		if (index > (LONG_MAX - 9) / 10)
+		    return JSON_ERR_BADPATH;
+		index = index * 10 + (*pe - '0');
+	    }
+	    if (pe == path + 1 || *pe != ']')
+		return JSON_ERR_BADPATH;
+	    if (cp >= ep || *cp != '[')
+		return JSON_ERR_ARRAYSTART;
+	    for (++cp;; ++cp) {
+		cp = json_span_ws(cp, ep);
+		if (cp < ep && *cp == ']')
+		    return JSON_ERR_NOTFOUND;
+		if (index-- == 0)
+		    break;
+		if ((cp = json_span_value(cp, ep)) == NULL)
+		    return JSON_ERR_BADSUBTRAIL;
+		cp = json_span_ws(cp, ep);
+		if (cp < ep && *cp == ']')
+		    return JSON_ERR_NOTFOUND;
+		else if (cp >= ep || *cp != ',')
+		    return JSON_ERR_BADSUBTRAIL;
+	    }
+	    path = pe + 1;
+	} else {
+	    size_t klen;
+
+	    if (*path == '.')
+		path++;
+	    klen = strcspn(path, ".[");
+	    if (klen == 0)
+		return JSON_ERR_BADPATH;
+	    if (cp >= ep || *cp != '{')
+		return JSON_ERR_OBSTART;
+	    for (++cp;; ++cp) {
+		char keybuf[JSON_ATTR_MAX + 1];
+		const char *kp;
+		size_t kn;
+
+		cp = json_span_ws(cp, ep);
+		if (cp < ep && *cp == '}')
+		    return JSON_ERR_NOTFOUND;
+		if (cp >= ep || *cp != '"')
+		    return JSON_ERR_ATTRSTART;
+		kp = cp + 1;
+		if ((cp = json_span_string(cp, ep)) == NULL)
+		    return JSON_ERR_BADSTRING;
+		kn = (size_t)(cp - 1 - kp);
+		/* an escaped name is decoded, as json_object_step() does */
+		if (memchr(kp, '\\', kn) != NULL) {
+		    if (json_read_string(&kp, keybuf, JSON_ATTR_MAX - 1,
+					 &kn) != 0)
+			kn = 0;	/* matches no path segment */
+		    kp = keybuf;
+		}
+		if (kn == klen && memcmp(kp, path, klen) == 0)
+		    break;
+		cp = json_span_ws(cp, ep);
+		if (cp >= ep || *cp != ':')
+		    return JSON_ERR_BADTRAIL;
+		cp = json_span_ws(cp + 1, ep);
+		if ((cp = json_span_value(cp, ep)) == NULL)
+		    return JSON_ERR_BADTRAIL;
+		cp = json_span_ws(cp, ep);
+		if (cp < ep && *cp == '}')
+		    return JSON_ERR_NOTFOUND;
+		else if (cp >= ep || *cp != ',')
+		    return JSON_ERR_BADTRAIL;
+	    }
+	    cp = json_span_ws(cp, ep);
+	    if (cp >= ep || *cp != ':')
+		return JSON_ERR_BADTRAIL;
+	    cp++;
+	    path += klen;
+	}
+    }
+    cp = json_span_ws(cp, ep);
+    *vp = cp;
+    if ((*vend = json_span_value(cp, ep)) == NULL)
+	return JSON_ERR_BADTRAIL;
+    json_debug_trace((1, "Path value spans %d bytes at offset %d\n",
+		      (int)(*vend - cp), (int)(cp - buf)));
+    return 0;
+}
+
+static int json_get_token(const char *buf, size_t len, const char *path,
+			  char *tok)
+/* copy the unquoted token path addresses into tok[JSON_VAL_MAX+1] */
+{
+    const char *vp, *vend;
+    int status = json_get_span(buf, len, path, &vp, &vend);
+
+    if (status != 0)
+	return status;
+    if (*vp == '"')
+	return JSON_ERR_QNONSTRING;
+    if (*vp == '{' || *vp == '[')
+	return JSON_ERR_NOARRAY;
+    if (vend - vp > JSON_VAL_MAX)
+	return JSON_ERR_TOKLONG;
+    memcpy(tok, vp, (size_t)(vend - vp));
+    tok[vend - vp] = '\0';
+    return 0;
+}
+
+int json_get_string(const char *buf, size_t len, const char *path,
+		    char *out, size_t outlen)
+{
+    const char *vp, *vend;
+    int status = json_get_span(buf, len, path, &vp, &vend);
+
+    if (status != 0)
+	return status;
+    if (*vp != '"')
+	return JSON_ERR_NONQSTRING;
+    if (outlen == 0)
+	return JSON_ERR_STRLONG;
+    /* the closing quote is known to lie inside the buffer */
+    ++vp;
+    return json_read_string(&vp, out, outlen - 1, NULL);
+}
+
+int json_get_integer(const char *buf, size_t len, const char *path,
+		     int *out)
+{
+    char tok[JSON_VAL_MAX + 1], *ep;
+    long val;
+    int status = json_get_token(buf, len, path, tok);
+
+    if (status != 0)
+	return status;
+    /* decimal only, as the template reader's atoi() takes it */
+    val = strtol(tok, &ep, 10);
+    if (ep == tok || *ep != '\0')
+	return JSON_ERR_BADNUM;
+    *out = (int)val;
+    return 0;
+}
+
+int json_get_uinteger(const char *buf, size_t len, const char *path,
+		      unsigned int *out)
+{
+    char tok[JSON_VAL_MAX + 1], *ep;
+    unsigned long val;
+    int status = json_get_token(buf, len, path, tok);
+
+    if (status != 0)
+	return status;
+    val = strtoul(tok, &ep, 10);
+    if (ep == tok || *ep != '\0')
+	return JSON_ERR_BADNUM;
+    *out = (unsigned int)val;
+    return 0;
+}
+
+int json_get_real(const char *buf, size_t len, const char *path,
+		  double *out)
+{
+    char tok[JSON_VAL_MAX + 1], *ep;
+    double val;
+    int status = json_get_token(buf, len, path, tok);
+
+    if (status != 0)
+	return status;
+    val = json_strtod(tok, &ep);
+    if (ep == tok || *ep != '\0')
+	return JSON_ERR_BADNUM;
+    *out = val;
+    return 0;
+}
+
+int json_get_boolean(const char *buf, size_t len, const char *path,
+		     bool *out)
+{
+    char tok[JSON_VAL_MAX + 1], *ep;
+    long val;
+    int status = json_get_token(buf, len, path, tok);
+
+    if (status != 0)
+	return status;
+    if (strcmp(tok, "true") == 0)
+	*out = true;
+    else if (strcmp(tok, "false") == 0)
+	*out = false;
+    else {
+	/* integer values are accepted as for t_boolean */
+	val = strtol(tok, &ep, 0);
+	if (ep == tok || *ep != '\0')
+	    return JSON_ERR_BADNUM;
+	*out = (val != 0);
+    }
+    return 0;
+}
+
+#ifdef TIME_ENABLE
+int json_get_time(const char *buf, size_t len, const char *path,
+		  double *out)
+{
+    char tbuf[JSON_VAL_MAX + 1];
+    double val;
+    int status = json_get_string(buf, len, path, tbuf, sizeof(tbuf));
+
+    if (status != 0)
+	return status;
+    val = iso8601_to_unix(tbuf);
+    if (val >= HUGE_VAL)
+	return JSON_ERR_BADNUM;
+    *out = val;
+    return 0;
+}
+#endif /* TIME_ENABLE */
+
 const char *json_error_string(int err)
 {
     const char *errors[] = {
@@ -847,6 +3718,12 @@ const char *json_error_string(int err)
 	"other data conversion error",
 	"unexpected null value or attribute pointer",
 	"object element specified, but no {",
+	"path not found in JSON",
+	"malformed JSON path",
+	"structural index full",
+	"string arena full",
+	"nesting too deep",
+	"store journal full",
     };
 
     if (err <= 0 || err >= (int)(sizeof(errors) / sizeof(errors[0])))
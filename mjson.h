@@ -5,8 +5,8 @@
  */
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
-#include <ctype.h>
 #ifdef TIME_ENABLE
 #include <time.h>
 #endif /* TIME_ENABLE */
@@ -16,7 +16,9 @@ typedef enum {t_integer, t_uinteger, t_real,
 	      t_time,
 	      t_object, t_structobject, t_array,
 	      t_check, t_ignore,
-	      t_short, t_ushort}
+	      t_short, t_ushort,
+	      t_bitset, t_columnobject,
+	      t_arenastring}
     json_type;
 
 struct json_enum_t {
@@ -24,6 +26,37 @@ struct json_enum_t {
     int		value;
 };
 
+/*
+ * The parser does not consult the locale, with one exception: a real
+ * (t_real, t_time fractions, json_get_real()) with more than 15
+ * significant digits or an exponent past 22 is handed to strtod(3),
+ * which reads the locale's decimal point.  Parsers from mjsongen.py
+ * and mjson.hpp use strtod(3) for every real.
+ */
+
+/*
+ * Variable-length strings.  A t_arenastring value is copied, with a
+ * NUL, into the next free bytes of a caller-supplied arena, and its
+ * target json_string_t records where it went and how long it is.  The
+ * parser never frees anything; JSON_ARENA_RESET() makes the whole
+ * arena available again in one step, invalidating every string in it.
+ * The template entry names the target and the arena in addr.astring.
+ * Values are decoded through the parser's value buffer on the way, so
+ * they are limited to JSON_VAL_MAX bytes like any other.
+ */
+struct json_arena_t {
+    char *base;
+    size_t size;
+    size_t used;
+};
+
+struct json_string_t {
+    const char *ptr;
+    size_t len;
+};
+
+#define JSON_ARENA_RESET(a)	((a)->used = 0)
+
 struct json_array_t {
     json_type element_type;
     union {
@@ -31,6 +64,8 @@ struct json_array_t {
 	    const struct json_attr_t *subtype;
 	    char *base;
 	    size_t stride;
+	    uint64_t *present;	/* optional, see json_options_t */
+	    const char *key;	/* optional, see json_update_object() */
 	} objects;
 	struct {
 	    char **ptrs;
@@ -55,10 +90,29 @@ struct json_array_t {
 	struct {
 	    bool *store;
 	} booleans;
+	struct {
+	    uint64_t *store;
+	} bitsets;
     } arr;
     int *count, maxlen;
+    /* optional, see below */
+    int (*callback)(const struct json_array_t *, int, void *);
+    void *arg;
 };
 
+/*
+ * Callback arrays.  If callback is set, each element is parsed into
+ * element 0 of the store (for strings, into the start of the string
+ * store) and callback(arr, index, arg) is then called with the
+ * element's position in the input.  The next element overwrites it, so
+ * maxlen need only be 1 and there is no limit on the array's length.
+ * Object elements get their defaults again each time.  A nonzero
+ * return stops the parse, which returns that code; it should be a
+ * positive one, negative returns become JSON_ERR_MISC.  count still
+ * receives the number of elements.  Elements are stored directly even
+ * under a journal, and are not matched by key in an update.
+ */
+
 struct json_attr_t {
     char *attribute;
     json_type type;
@@ -69,8 +123,16 @@ struct json_attr_t {
 	unsigned short *ushortint;
 	double *real;
 	char *string;
+	struct {
+	    union {
+		struct json_string_t *store;
+		size_t offset;	/* in a structure, see STRUCTASTRING */
+	    } target;
+	    struct json_arena_t *arena;
+	} astring;
 	bool *boolean;
 	char *character;
+	uint64_t *bitset;
 	const struct json_attr_t *attrs;
 	const struct json_array_t array;
 	size_t offset;
@@ -90,16 +152,237 @@ struct json_attr_t {
     bool nodefault;
 };
 
-#define JSON_ATTR_MAX	31	/* max chars in JSON attribute name */
+#define JSON_ATTR_MAX	31	/* max chars in an escaped attribute name */
 #define JSON_VAL_MAX	512	/* max chars in JSON value part */
+#define JSON_DEPTH_MAX	8	/* default max nesting of objects and arrays */
+
+/*
+ * One level of nesting in progress: an object or array the parser has
+ * started but not finished.  The members are private to the parser;
+ * callers only allocate arrays of these for json_options_t.
+ */
+struct json_frame_t {
+    bool is_array, resuming, wanted, satisfied, update;
+    int state, offset, count, lastattr;
+    const struct json_array_t *arr;	/* the array, or an object's parent */
+    const struct json_attr_t *attrs, *cursor;
+    uint64_t *present;
+    const struct json_options_t *opts;
+    size_t words;
+    char *tp;
+    size_t dflt, dflt_end, dflt_next;	/* journaled defaults */
+};
+
+/*
+ * Per-call options for json_read_object_opts().  A zeroed structure
+ * behaves exactly like json_read_object().
+ *
+ * present: if non-NULL, it is cleared and then bit i is set for each
+ * template entry attrs[i] that the input actually supplied.  It must
+ * hold JSON_BITSET_WORDS(n) words for an n-entry template.  Object
+ * arrays can report the same thing per element through
+ * arr.objects.present, which holds that many words for each of the
+ * maxlen elements, one element after another.
+ *
+ * required: if non-NULL, a bitmap of the same shape as present marking
+ * the entries the caller needs; present must then be set too.  As soon
+ * as all of them have been seen the parser stops converting.  It skips
+ * the rest of the object without interpreting it, or, if return_early
+ * is set, returns straight away with the end pointer at the comma
+ * following the last required value.
+ *
+ * select: if non-NULL, a bitmap of the same shape marking the entries
+ * this caller wants.  Other entries are still recognized and their
+ * values checked as usual, so the mask never changes the result, but
+ * those values are neither converted nor stored and their defaults are
+ * not applied.  For an attribute with several type specs, the bit of
+ * the first one governs.
+ *
+ * cache: if non-NULL, a json_cache_t remembering which message each
+ * template's targets currently hold; see below.
+ *
+ * frames, maxdepth: nesting is parsed without recursion, one frame per
+ * object or array open at once, the outermost object included.  By
+ * default the parser has JSON_DEPTH_MAX frames of its own.  If frames
+ * is non-NULL it is used instead and holds maxdepth entries; otherwise
+ * a nonzero maxdepth lowers the limit.  Input nested deeper than the
+ * limit fails with JSON_ERR_DEPTH.
+ *
+ * order: if non-NULL, a json_order_t predicting the order of the
+ * top-level attributes from earlier messages; see below.
+ *
+ * update: if set, apply the input to the targets as an update, as
+ * json_update_object() does.
+ *
+ * journal: if non-NULL, the parse is all or nothing; see below.
+ */
+struct json_options_t {
+    uint64_t *present;
+    const uint64_t *required;
+    bool return_early;
+    const uint64_t *select;
+    struct json_cache_t *cache;
+    struct json_frame_t *frames;
+    int maxdepth;
+    struct json_order_t *order;
+    bool update;
+    struct json_journal_t *journal;
+};
+
+/*
+ * Commit-on-success parsing.  With a journal, json_read_object_opts()
+ * records each store in the caller's buffer of size bytes instead of
+ * making it, and copies the recorded values into the targets only once
+ * the whole input has parsed.  On any error the targets, present
+ * bitmaps aside, are left as they were.  After a successful parse used
+ * says how many bytes it needed; if the buffer is too small the call
+ * fails with JSON_ERR_JOURNALFULL and nothing is stored.  Arena strings are
+ * copied into the arena at once, but a failed parse gives the space
+ * back.  Nothing is allocated.
+ */
+struct json_journal_t {
+    char *buf;
+    size_t size;
+    size_t used;
+    /* internal */
+    size_t undo;
+    char *base;
+    size_t dflt, dflt_end, dflt_next;
+};
+
+/*
+ * Key-order prediction.  The caller supplies nslots zeroed slots, one
+ * more than the template has entries.  Slot 0 remembers which entry
+ * the first attribute of the last message matched, and slot i + 1 which
+ * one followed attrs[i].  Each attribute name is compared with the
+ * predicted entry first, by length and memcmp(), and looked up in the
+ * usual way only when that fails.  Producers that always write their
+ * keys in the same order hit every time after the first message.  The
+ * slots are cleared when the structure is used with another template.
+ */
+struct json_order_slot_t {
+    int next;	/* 1 + index of the predicted entry, 0 if none */
+    int len;	/* length of its name */
+};
+
+struct json_order_t {
+    const struct json_attr_t *attrs;
+    struct json_order_slot_t *slots;
+    int nslots;
+    unsigned long hits, misses;
+};
+
+/*
+ * Identical-message cache.  The caller supplies nentries zeroed
+ * entries.  Each template (by address) maps to one entry, which records
+ * a hash and the length of the last object successfully parsed into it;
+ * what follows the object is not part of the key.  When the same object
+ * arrives again for that template its targets already hold the result,
+ * so json_read_object_opts() returns 0 at once with unchanged set, and
+ * counts a hit.  Every call with a cache clears unchanged first.  This
+ * is only sound if every parse into a cached template goes through the
+ * cache and nothing else writes its targets in between.  The cache is
+ * bypassed when present, required or select are in use.
+ *
+ * Without text, a hit means only that the 64-bit hash and the length
+ * match, so two different objects that collide would be taken for
+ * each other.  If text is non-NULL it is split evenly between the
+ * entries, each keeps a copy of its object, and a hit also needs the
+ * bytes to match; objects longer than textsize / nentries are then
+ * parsed but not cached.
+ */
+struct json_cache_entry_t {
+    const struct json_attr_t *attrs;
+    uint64_t hash;
+    size_t len;		/* of the object, up to its closing brace */
+};
+
+struct json_cache_t {
+    struct json_cache_entry_t *entries;
+    int nentries;
+    char *text;		/* optional copies of the cached inputs */
+    size_t textsize;
+    bool unchanged;	/* set if the last call was a hit */
+    unsigned long hits, misses;
+};
+
+/*
+ * Structural index filled in by json_index() or json_tokenize().  The
+ * caller supplies the tokens array and sets maxtokens; the lexer sets
+ * buf and ntokens.  Offsets are relative to buf.  A string token
+ * excludes its quotes; an object or array token spans its brackets and
+ * is followed by its contents, object members as key/value token pairs.
+ * next is the index of the first token after the whole value, and
+ * parent the index of the enclosing object or array, -1 at top level.
+ *
+ * json_tokenize() resumes where it left off if ntokens is nonzero, so
+ * after JSON_ERR_INDEXFULL the caller can copy the tokens into a larger
+ * array, update tokens and maxtokens, and call it again on the same
+ * buffer.  pos, open and expect hold its place in between.  complete
+ * is set only once the outermost value has been closed;
+ * json_read_object_index() refuses an index without it.
+ */
+typedef enum {tok_object, tok_array, tok_string, tok_bare} json_tokkind;
+
+struct json_token_t {
+    json_tokkind kind;
+    int start, end;
+    int next;
+    int parent;
+};
+
+struct json_index_t {
+    const char *buf;
+    struct json_token_t *tokens;
+    int maxtokens;
+    int ntokens;
+    int pos, open, expect;
+    bool complete;
+};
+
+/*
+ * A template compiled to machine code by json_jit_compile().  code is
+ * NULL when the platform or the template is not supported by the
+ * compiler; json_jit_read() then hands the text to json_read_object().
+ * The three entry points live in code and are private to mjson.c.
+ */
+struct json_jit_t {
+    const struct json_attr_t *attrs;
+    void *code;
+    size_t codesize;
+    int (*match)(const char *, size_t);
+    int (*store)(int, const void *);
+    void (*defaults)(void);
+};
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 int json_read_object(const char *, const struct json_attr_t *,
 		     const char **);
+int json_read_object_opts(const char *, const struct json_attr_t *,
+			  const struct json_options_t *, const char **);
 int json_read_array(const char *, const struct json_array_t *,
 		    const char **);
+int json_update_object(const char *, const struct json_attr_t *,
+		       const char **);
+int json_validate_object(const char *, size_t, const struct json_attr_t *);
+int json_attr_depth(const struct json_attr_t *);
+int json_index(const char *, struct json_index_t *, const char **);
+int json_tokenize(const char *, struct json_index_t *, const char **);
+int json_read_object_index(const struct json_index_t *,
+			   const struct json_attr_t *);
+bool json_jit_compile(const struct json_attr_t *, struct json_jit_t *);
+int json_jit_read(const struct json_jit_t *, const char *, const char **);
+void json_jit_free(struct json_jit_t *);
+int json_get_string(const char *, size_t, const char *, char *, size_t);
+int json_get_integer(const char *, size_t, const char *, int *);
+int json_get_uinteger(const char *, size_t, const char *, unsigned int *);
+int json_get_real(const char *, size_t, const char *, double *);
+int json_get_boolean(const char *, size_t, const char *, bool *);
+#ifdef TIME_ENABLE
+int json_get_time(const char *, size_t, const char *, double *);
+#endif /* TIME_ENABLE */
 const char *json_error_string(int);
 
 #ifdef TIME_ENABLE
@@ -135,6 +418,12 @@ void json_enable_debug(int, FILE *);
 #define JSON_ERR_BADNUM		21	/* error while parsing a numerical argument */
 #define JSON_ERR_NULLPTR	22	/* unexpected null value or attribute pointer */
 #define JSON_ERR_NOCURLY	23	/* object element specified, but no { */
+#define JSON_ERR_NOTFOUND	24	/* path not found in JSON */
+#define JSON_ERR_BADPATH	25	/* malformed JSON path */
+#define JSON_ERR_INDEXFULL	26	/* structural index full */
+#define JSON_ERR_ARENAFULL	27	/* string arena full */
+#define JSON_ERR_DEPTH		28	/* objects or arrays nested too deeply */
+#define JSON_ERR_JOURNALFULL	29	/* store journal full */
 
 /*
  * Use the following macros to declare template initializers for structobject
@@ -142,11 +431,27 @@ void json_enable_debug(int, FILE *);
  *
  * STRUCTOBJECT takes a structure name s, and a fieldname f in s.
  *
+ * STRUCTBIT is like STRUCTOBJECT for a t_bitset member; f names a
+ * uint64_t array in s and n is the bit number within it.
+ *
+ * STRUCTASTRING is like STRUCTOBJECT for a t_arenastring member; f names
+ * a json_string_t in s and a is the json_arena_t the text goes into.
+ *
  * STRUCTARRAY takes the name of a structure array, a pointer to a an
  * initializer defining the subobject type, and the address of an integer to
  * store the length in.
+ *
+ * COLUMNARRAY is the column-wise counterpart of STRUCTARRAY.  It takes a
+ * structure whose members are arrays (one column per attribute), a
+ * pointer to an initializer whose STRUCTOBJECT offsets name those
+ * columns, the address of an integer to store the length in, and the
+ * number of rows in each column.
  */
 #define STRUCTOBJECT(s, f)	.addr.offset = offsetof(s, f)
+#define STRUCTBIT(s, f, n)	.addr.offset = offsetof(s, f), .len = n
+#define STRUCTASTRING(s, f, a) \
+	.addr.astring.target.offset = offsetof(s, f), \
+	.addr.astring.arena = a
 #define STRUCTARRAY(a, e, n) \
 	.addr.array.element_type = t_structobject, \
 	.addr.array.arr.objects.subtype = e, \
@@ -154,5 +459,18 @@ void json_enable_debug(int, FILE *);
 	.addr.array.arr.objects.stride = sizeof(a[0]), \
 	.addr.array.count = n, \
 	.addr.array.maxlen = (int)(sizeof(a)/sizeof(a[0]))
+#define COLUMNARRAY(c, e, n, m) \
+	.addr.array.element_type = t_columnobject, \
+	.addr.array.arr.objects.subtype = e, \
+	.addr.array.arr.objects.base = (char*)&(c), \
+	.addr.array.count = n, \
+	.addr.array.maxlen = m
+
+/*
+ * Helpers for t_bitset storage.  Bit n lives in word n/64 of a uint64_t
+ * array, least significant bit first.
+ */
+#define JSON_BITSET_WORDS(n)	(((n) + 63) / 64)
+#define JSON_BITSET_TEST(s, n)	((int)(((s)[(n) / 64] >> ((n) % 64)) & 1))
 
 /* json.h ends here */
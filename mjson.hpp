@@ -0,0 +1,520 @@
+/*
+ * mjson.hpp - compile-time microjson bindings for C++17
+ *
+ * A structure's fields are declared once, as a constexpr schema built
+ * from member pointers:
+ *
+ *	struct tpv { char device[32]; int mode; double lat, alt; };
+ *
+ *	constexpr auto tpv_schema = mjson::schema<tpv>(
+ *	    mjson::check("class", "TPV"),
+ *	    mjson::field("device", &tpv::device),
+ *	    mjson::field("mode", &tpv::mode, -1),
+ *	    mjson::field("lat", &tpv::lat, NAN),
+ *	    mjson::nodefault(mjson::field("alt", &tpv::alt)),
+ *	    mjson::ignore(""));
+ *
+ *	status = tpv_schema.read(buf, fix, &end);
+ *
+ * The schema constructor builds a perfect hash of the attribute names
+ * at compile time, and read() dispatches to one inlined converter per
+ * field, so no template table is interpreted at run time.  read()
+ * returns the same codes json_read_object() would for the equivalent
+ * json_attr_t template.  Field types are int, unsigned int, short,
+ * unsigned short, double, bool, char and char arrays (strings), plus
+ * check and ignore entries; an ignore entry named "" accepts any
+ * unknown attribute and must come last.  Sub-objects, arrays,
+ * enumerations and times are left to the C interface in mjson.h.
+ *
+ * This file is Copyright (c) 2026 by the microjson contributors
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#ifndef MJSON_HPP
+#define MJSON_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <tuple>
+#include <utility>
+
+#include "mjson.h"
+
+namespace mjson {
+
+namespace detail {
+
+template <class T> struct identity { typedef T type; };
+
+/* json_cclass in mjson.c, as constexpr: never the current locale */
+constexpr bool is_space(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+constexpr bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool is_xdigit(char c)
+{
+    return is_digit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+}
+
+constexpr std::size_t length(const char *s)
+{
+    std::size_t n = 0;
+
+    while (s[n] != '\0')
+	n++;
+    return n;
+}
+
+constexpr bool same(const char *a, const char *b)
+{
+    std::size_t i = 0;
+
+    for (; a[i] != '\0' && a[i] == b[i]; i++)
+	continue;
+    return a[i] == b[i];
+}
+
+constexpr std::uint32_t hash(const char *s, std::size_t n,
+			     std::uint32_t seed)
+{
+    std::uint32_t h = 2166136261u ^ seed;
+
+    for (std::size_t i = 0; i < n; i++) {
+	h ^= (unsigned char)s[i];
+	h *= 16777619u;
+    }
+    return h;
+}
+
+/* hash table size for n keys: a power of two around n*n/2 */
+constexpr std::size_t slots(std::size_t n)
+{
+    std::size_t m = 8;
+
+    while (m < n * n / 2)
+	m *= 2;
+    return m;
+}
+
+inline int read_string(const char **cpp, char *dst, std::size_t size,
+		       std::size_t *lenp = nullptr)
+/* decode a JSON string body exactly as json_read_object() does */
+{
+    const char *cp = *cpp;
+    std::size_t len = 0, run;
+    unsigned int u;
+    int n;
+
+    for (;;) {
+	run = std::strcspn(cp, "\"\\");
+	if (run > size - len)
+	    return JSON_ERR_STRLONG;
+	std::memcpy(dst + len, cp, run);
+	len += run;
+	cp += run;
+	if (*cp == '"')
+	    break;
+	else if (*cp == '\0')
+	    return JSON_ERR_BADSTRING;
+	if (len >= size)
+	    return JSON_ERR_STRLONG;
+	switch (*++cp) {
+	case 'b':
+	    dst[len++] = '\b';
+	    break;
+	case 'f':
+	    dst[len++] = '\f';
+	    break;
+	case 'n':
+	    dst[len++] = '\n';
+	    break;
+	case 'r':
+	    dst[len++] = '\r';
+	    break;
+	case 't':
+	    dst[len++] = '\t';
+	    break;
+	case 'u':
+	    for (n = 0, u = 0; n < 4 && is_xdigit(cp[1]); n++) {
+		++cp;
+		u = u * 16 + (unsigned int)(is_digit(*cp)
+		    ? *cp - '0' : (*cp | 0x20) - 'a' + 10);
+	    }
+	    if (n != 4)
+		return JSON_ERR_BADSTRING;
+	    dst[len++] = (char)(unsigned char)u;
+	    break;
+	case '\0':
+	    return JSON_ERR_BADSTRING;
+	default:
+	    dst[len++] = *cp;
+	    break;
+	}
+	++cp;
+    }
+    dst[len] = '\0';
+    *cpp = cp + 1;
+    if (lenp != nullptr)
+	*lenp = len;
+    return 0;
+}
+
+/* one scalar value: decoded into a buffer if quoted, else left in place */
+struct value {
+    char buf[JSON_VAL_MAX + 1];
+    const char *text;
+    std::size_t len;
+    bool quoted;
+};
+
+inline int read_value(const char **cpp, value &v, std::size_t size)
+{
+    const char *cp = *cpp;
+
+    while (is_space(*cp) || *cp == ':')
+	cp++;
+    if (*cp == '[' || *cp == '{')
+	return JSON_ERR_NOARRAY;
+    if (*cp == '"') {
+	int status;
+
+	++cp;
+	status = read_string(&cp, v.buf, size);
+	if (status != 0)
+	    return status;
+	v.text = v.buf;
+	v.len = std::strlen(v.buf);
+	v.quoted = true;
+    } else {
+	v.text = cp;
+	while (*cp != '\0' && !is_space(*cp)
+	       && *cp != ',' && *cp != '}')
+	    cp++;
+	v.len = (std::size_t)(cp - v.text);
+	if (v.len > JSON_VAL_MAX)
+	    return JSON_ERR_TOKLONG;
+	v.quoted = false;
+    }
+    *cpp = cp;
+    return 0;
+}
+
+/* the interpreter's decode limit for a string of at most maxlen bytes */
+constexpr std::size_t value_size(std::size_t maxlen)
+{
+    return maxlen < JSON_VAL_MAX - 1 ? maxlen + 1 : JSON_VAL_MAX;
+}
+
+} // namespace detail
+
+/* field descriptors, normally made with the functions below */
+
+template <class S, class T> struct scalar_field {
+    const char *name;
+    T S::*member;
+    T dflt;
+    bool nodefault;
+};
+
+template <class S, std::size_t N> struct string_field {
+    const char *name;
+    char (S::*member)[N];
+    bool nodefault;
+};
+
+struct check_field {
+    const char *name;
+    const char *value;
+};
+
+struct ignore_field {
+    const char *name;
+};
+
+template <class S, class T>
+constexpr scalar_field<S, T> field(const char *name, T S::*member,
+				   typename detail::identity<T>::type dflt
+				   = T())
+{
+    return scalar_field<S, T>{name, member, dflt, false};
+}
+
+template <class S, std::size_t N>
+constexpr string_field<S, N> field(const char *name, char (S::*member)[N])
+{
+    return string_field<S, N>{name, member, false};
+}
+
+constexpr check_field check(const char *name, const char *value)
+{
+    return check_field{name, value};
+}
+
+constexpr ignore_field ignore(const char *name)
+{
+    return ignore_field{name};
+}
+
+/* leave the member alone when the attribute is absent */
+template <class F> constexpr F nodefault(F f)
+{
+    f.nodefault = true;
+    return f;
+}
+
+template <class S, class... F> class object {
+public:
+    constexpr explicit object(F... f)
+	: fields_(f...), names_{f.name...}, lengths_{}, table_{}, seed_(0),
+	  wildcard_(-1)
+    {
+	for (std::size_t i = 0; i < nfields; i++) {
+	    lengths_[i] = detail::length(names_[i]);
+	    if (lengths_[i] == 0)
+		wildcard_ = (int)i;
+	    for (std::size_t j = 0; j < i; j++)
+		if (detail::same(names_[i], names_[j]))
+		    throw "mjson: attribute named twice";
+	}
+	/* find a seed that gives every name its own slot */
+	for (;; seed_++) {
+	    bool clash = false;
+
+	    for (std::size_t s = 0; s < nslots; s++)
+		table_[s] = 0;
+	    for (std::size_t i = 0; i < nfields && !clash; i++) {
+		if (lengths_[i] == 0)
+		    continue;
+		std::size_t s = detail::hash(names_[i], lengths_[i], seed_)
+		    & (nslots - 1);
+
+		if (table_[s] != 0)
+		    clash = true;
+		else
+		    table_[s] = (unsigned char)(i + 1);
+	    }
+	    if (!clash)
+		break;
+	}
+    }
+
+    int read(const char *cp, S &out, const char **end = nullptr) const
+    {
+	detail::value v;
+	char keybuf[JSON_ATTR_MAX + 1];
+	const char *kp;
+	std::size_t klen;
+	int f, status;
+
+	if (end != nullptr)
+	    *end = nullptr;
+	defaults(out, std::index_sequence_for<F...>());
+	while (detail::is_space(*cp))
+	    cp++;
+	if (*cp != '{') {
+	    if (end != nullptr)
+		*end = cp;
+	    return JSON_ERR_OBSTART;
+	}
+	for (cp++;;) {
+	    while (detail::is_space(*cp))
+		cp++;
+	    if (*cp == '}')
+		break;
+	    if (*cp != '"') {
+		if (end != nullptr)
+		    *end = cp;
+		return JSON_ERR_ATTRSTART;
+	    }
+	    kp = ++cp;
+	    cp += std::strcspn(cp, "\"\\");
+	    if (*cp == '\0')
+		return JSON_ERR_BADTRAIL;
+	    else if (*cp == '"')
+		klen = (std::size_t)(cp++ - kp);
+	    else {
+		/* names with escapes are decoded before the lookup */
+		cp = kp;
+		status = detail::read_string(&cp, keybuf, JSON_ATTR_MAX - 1,
+					     &klen);
+		if (status == JSON_ERR_STRLONG)
+		    return JSON_ERR_ATTRLEN;
+		else if (status != 0)
+		    return status;
+		kp = keybuf;
+	    }
+	    f = lookup(kp, klen);
+	    if (f < 0)
+		return JSON_ERR_BADATTR;
+	    status = store((std::size_t)f, &cp, v, out,
+			   std::index_sequence_for<F...>());
+	    if (status != 0)
+		return status;
+	    while (detail::is_space(*cp))
+		cp++;
+	    if (*cp == '}')
+		break;
+	    if (*cp != ',') {
+		if (end != nullptr)
+		    *end = cp;
+		return JSON_ERR_BADTRAIL;
+	    }
+	    cp++;
+	}
+	/* in case there's another object following, consume trailing WS */
+	for (cp++; detail::is_space(*cp); cp++)
+	    continue;
+	if (end != nullptr)
+	    *end = cp;
+	return 0;
+    }
+
+private:
+    static constexpr std::size_t nfields = sizeof...(F);
+    static constexpr std::size_t nslots = detail::slots(sizeof...(F));
+    static_assert(sizeof...(F) < 256, "mjson: too many fields");
+
+    std::tuple<F...> fields_;
+    std::array<const char *, sizeof...(F)> names_;
+    std::array<std::size_t, sizeof...(F)> lengths_;
+    std::array<unsigned char, nslots> table_;
+    std::uint32_t seed_;
+    int wildcard_;
+
+    int lookup(const char *kp, std::size_t klen) const
+    {
+	int i = table_[detail::hash(kp, klen, seed_) & (nslots - 1)] - 1;
+
+	if (i >= 0 && lengths_[i] == klen
+	    && std::memcmp(names_[i], kp, klen) == 0)
+	    return i;
+	return wildcard_;
+    }
+
+    /* defaults */
+
+    template <class T>
+    static void dflt(const scalar_field<S, T> &f, S &out)
+    {
+	if (!f.nodefault)
+	    out.*f.member = f.dflt;
+    }
+
+    template <std::size_t N>
+    static void dflt(const string_field<S, N> &f, S &out)
+    {
+	if (!f.nodefault)
+	    (out.*f.member)[0] = '\0';
+    }
+
+    static void dflt(const check_field &, S &) {}
+    static void dflt(const ignore_field &, S &) {}
+
+    template <std::size_t... I>
+    void defaults(S &out, std::index_sequence<I...>) const
+    {
+	(dflt(std::get<I>(fields_), out), ...);
+    }
+
+    /* converters */
+
+    template <class T>
+    static int convert(const scalar_field<S, T> &f, const char **cpp,
+		       detail::value &v, S &out)
+    {
+	int status = detail::read_value(cpp, v, JSON_VAL_MAX);
+
+	if (status != 0)
+	    return status;
+	if constexpr (std::is_same<T, char>::value) {
+	    if (v.len > 1)
+		return JSON_ERR_STRLONG;
+	    out.*f.member = v.len > 0 ? v.text[0] : '\0';
+	} else {
+	    if (v.quoted)
+		return JSON_ERR_QNONSTRING;
+	    if constexpr (std::is_same<T, double>::value)
+		out.*f.member = std::strtod(v.text, nullptr);
+	    else if constexpr (std::is_same<T, bool>::value)
+		out.*f.member = (v.len == 4
+				 && std::memcmp(v.text, "true", 4) == 0)
+		    || std::strtol(v.text, nullptr, 0) != 0;
+	    else {
+		static_assert(std::is_same<T, int>::value
+			      || std::is_same<T, unsigned int>::value
+			      || std::is_same<T, short>::value
+			      || std::is_same<T, unsigned short>::value,
+			      "mjson: unsupported field type");
+		out.*f.member = (T)(int)std::strtol(v.text, nullptr, 10);
+	    }
+	}
+	return 0;
+    }
+
+    template <std::size_t N>
+    static int convert(const string_field<S, N> &f, const char **cpp,
+		       detail::value &v, S &out)
+    {
+	constexpr std::size_t cl = N - 1;
+	int status = detail::read_value(cpp, v, detail::value_size(cl));
+
+	if (status != 0)
+	    return status;
+	if (!v.quoted)
+	    return JSON_ERR_NONQSTRING;
+	std::memset(out.*f.member, '\0', N);
+	std::memcpy(out.*f.member, v.text, v.len < cl ? v.len : cl);
+	return 0;
+    }
+
+    static int convert(const check_field &f, const char **cpp,
+		       detail::value &v, S &)
+    {
+	int status = detail::read_value(cpp, v,
+			     detail::value_size(detail::length(f.value)));
+
+	if (status != 0)
+	    return status;
+	if (!v.quoted)
+	    return JSON_ERR_NONQSTRING;
+	if (std::strcmp(v.text, f.value) != 0)
+	    return JSON_ERR_CHECKFAIL;
+	return 0;
+    }
+
+    static int convert(const ignore_field &, const char **cpp,
+		       detail::value &v, S &)
+    {
+	return detail::read_value(cpp, v, JSON_VAL_MAX);
+    }
+
+    template <std::size_t... I>
+    int store(std::size_t f, const char **cpp, detail::value &v, S &out,
+	      std::index_sequence<I...>) const
+    {
+	int status = JSON_ERR_BADATTR;
+
+	(void)((f == I
+		&& (status = convert(std::get<I>(fields_), cpp, v, out), true))
+	       || ...);
+	return status;
+    }
+};
+
+template <class S, class... F> constexpr object<S, F...> schema(F... f)
+{
+    return object<S, F...>(f...);
+}
+
+} // namespace mjson
+
+#endif /* MJSON_HPP */
@@ -0,0 +1,459 @@
+#!/usr/bin/env python3
+#
+# mjsongen.py - generate a specialised microjson parser for one template
+#
+# This file is Copyright (c) 2026 by the microjson contributors
+# SPDX-License-Identifier: BSD-2-Clause
+#
+"""\
+Usage: mjsongen.py [-o basename] description.json
+
+Reads a description of a flat JSON object template and writes
+basename.h (a structure declaration and a prototype) and basename.c (a
+parser specialised for that structure).  The generated parser returns
+the same codes as json_read_object() would for the equivalent
+json_attr_t template, but dispatches on key bytes with a switch,
+converts each field with inline code and stores it directly.
+
+The description is a JSON object:
+
+  {
+    "function": "json_read_tpv",
+    "struct": "tpv_t",
+    "attributes": [
+      {"name": "class",  "type": "check",   "check": "TPV"},
+      {"name": "device", "type": "string",  "len": 32},
+      {"name": "mode",   "type": "integer", "default": "-1"},
+      {"name": "lat",    "type": "real",    "default": "NAN"},
+      {"name": "",       "type": "ignore"}
+    ]
+  }
+
+Types are integer, uinteger, short, ushort, real, boolean, character,
+string, check and ignore.  "field" names the structure member when it
+differs from the attribute name, "default" is a C expression (zero if
+omitted), and "nodefault": true leaves the member alone when the
+attribute is absent.  An ignore entry named "" accepts any unknown
+attribute.  Sub-objects, arrays, enumerations and times are left to
+the interpreter.
+"""
+
+import getopt
+import json
+import sys
+
+JSON_ATTR_MAX = 31
+JSON_VAL_MAX = 512
+
+ctypes = {
+    "integer": "int",
+    "uinteger": "unsigned int",
+    "short": "short",
+    "ushort": "unsigned short",
+    "real": "double",
+    "boolean": "bool",
+    "character": "char",
+    "string": "char",
+}
+
+runtime = r'''
+/* classify as the interpreter does: the C locale, whatever is set */
+static bool gen_isspace(unsigned char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static bool gen_isdigit(unsigned char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool gen_isxdigit(unsigned char c)
+{
+    return gen_isdigit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+}
+
+static int gen_read_string(const char **cpp, char *dst, size_t size,
+			   size_t *lenp)
+/* decode a JSON string body exactly as json_read_object() does */
+{
+    const char *cp = *cpp;
+    size_t len = 0, run;
+    unsigned int u;
+    int n;
+
+    for (;;) {
+	run = strcspn(cp, "\"\\");
+	if (run > size - len)
+	    return JSON_ERR_STRLONG;
+	memcpy(dst + len, cp, run);
+	len += run;
+	cp += run;
+	if (*cp == '"')
+	    break;
+	else if (*cp == '\0')
+	    return JSON_ERR_BADSTRING;
+	if (len >= size)
+	    return JSON_ERR_STRLONG;
+	switch (*++cp) {
+	case 'b':
+	    dst[len++] = '\b';
+	    break;
+	case 'f':
+	    dst[len++] = '\f';
+	    break;
+	case 'n':
+	    dst[len++] = '\n';
+	    break;
+	case 'r':
+	    dst[len++] = '\r';
+	    break;
+	case 't':
+	    dst[len++] = '\t';
+	    break;
+	case 'u':
+	    for (n = 0, u = 0; n < 4 && gen_isxdigit(cp[1]); n++) {
+		++cp;
+		u = u * 16 + (unsigned int)(gen_isdigit(*cp)
+		    ? *cp - '0' : (*cp | 0x20) - 'a' + 10);
+	    }
+	    if (n != 4)
+		return JSON_ERR_BADSTRING;
+	    dst[len++] = (char)(unsigned char)u;
+	    break;
+	case '\0':
+	    return JSON_ERR_BADSTRING;
+	default:
+	    dst[len++] = *cp;
+	    break;
+	}
+	++cp;
+    }
+    dst[len] = '\0';
+    *cpp = cp + 1;
+    if (lenp != NULL)
+	*lenp = len;
+    return 0;
+}
+
+static int gen_read_value(const char **cpp, char *valbuf, size_t size,
+			  const char **vpp, size_t *vlenp, bool *quotedp)
+/*
+ * Collect one scalar value.  A quoted value is decoded into valbuf; a
+ * bare token is left in place and described by *vpp and *vlenp.
+ */
+{
+    const char *cp = *cpp;
+
+    while (gen_isspace(*cp) || *cp == ':')
+	cp++;
+    if (*cp == '[' || *cp == '{')
+	return JSON_ERR_NOARRAY;
+    if (*cp == '"') {
+	int status;
+
+	++cp;
+	status = gen_read_string(&cp, valbuf, size, NULL);
+	if (status != 0)
+	    return status;
+	*vpp = valbuf;
+	*vlenp = strlen(valbuf);
+	*quotedp = true;
+    } else {
+	*vpp = cp;
+	while (*cp != '\0' && !gen_isspace(*cp)
+	       && *cp != ',' && *cp != '}')
+	    cp++;
+	*vlenp = (size_t)(cp - *vpp);
+	if (*vlenp > JSON_VAL_MAX)
+	    return JSON_ERR_TOKLONG;
+	*quotedp = false;
+    }
+    *cpp = cp;
+    return 0;
+}
+'''
+
+
+def fail(msg):
+    sys.stderr.write("mjsongen: %s\n" % msg)
+    sys.exit(1)
+
+
+def cstring(s):
+    "Render a Python string as a C string literal."
+    return json.dumps(s)
+
+
+def load(path):
+    "Read and check a template description."
+    with open(path) as fp:
+        desc = json.load(fp)
+    for key in ("function", "struct", "attributes"):
+        if key not in desc:
+            fail("description lacks %s" % key)
+    seen = set()
+    for attr in desc["attributes"]:
+        name, typ = attr.get("name"), attr.get("type")
+        if name is None or typ is None:
+            fail("every attribute needs a name and a type")
+        if typ not in ctypes and typ not in ("check", "ignore"):
+            fail("%s: type %s is not supported by the generator"
+                 % (name, typ))
+        if name in seen:
+            fail("%s: attributes with several type specs are not supported"
+                 % name)
+        if len(name) > JSON_ATTR_MAX - 1:
+            fail("%s: attribute name too long" % name)
+        if typ == "string" and attr.get("len", 0) < 1:
+            fail("%s: strings need a len" % name)
+        if typ == "check" and "check" not in attr:
+            fail("%s: check entries need a check value" % name)
+        if name == "" and typ != "ignore":
+            fail("only an ignore entry may be unnamed")
+        if name == "" and attr is not desc["attributes"][-1]:
+            fail("the unnamed ignore entry must come last")
+        seen.add(name)
+    return desc
+
+
+def field(attr):
+    return attr.get("field", attr["name"])
+
+
+def emit_header(desc, base):
+    guard = base.upper().replace("-", "_").replace("/", "_") + "_H"
+    out = []
+    out.append("/* %s.h - generated by mjsongen.py, do not edit */\n" % base)
+    out.append("#ifndef %s\n#define %s\n\n" % (guard, guard))
+    out.append("#include <stdbool.h>\n\n")
+    out.append("struct %s {\n" % desc["struct"])
+    for attr in desc["attributes"]:
+        typ = attr["type"]
+        if typ in ("check", "ignore"):
+            continue
+        if typ == "string":
+            out.append("    char %s[%d];\n" % (field(attr), attr["len"]))
+        else:
+            out.append("    %s %s;\n" % (ctypes[typ], field(attr)))
+    out.append("};\n\n")
+    out.append("int %s(const char *, struct %s *, const char **);\n\n"
+               % (desc["function"], desc["struct"]))
+    out.append("#endif /* %s */\n" % guard)
+    return "".join(out)
+
+
+def emit_dispatch(named):
+    "Emit a switch on key length, then on first byte, then memcmp."
+    out = ["\tswitch (klen) {\n"]
+    bylen = {}
+    for (i, attr) in named:
+        bylen.setdefault(len(attr["name"]), []).append((i, attr))
+    for klen in sorted(bylen):
+        out.append("\tcase %d:\n" % klen)
+        group = bylen[klen]
+        byfirst = {}
+        for (i, attr) in group:
+            byfirst.setdefault(attr["name"][0], []).append((i, attr))
+        out.append("\t    switch (kp[0]) {\n")
+        for first in sorted(byfirst):
+            out.append("\t    case '%s':\n"
+                       % ("\\'" if first == "'" else
+                          "\\\\" if first == "\\" else first))
+            for (n, (i, attr)) in enumerate(byfirst[first]):
+                rest = attr["name"][1:]
+                if rest:
+                    out.append("\t\t%sif (memcmp(kp + 1, %s, %d) == 0)\n"
+                               "\t\t    f = %d;\n"
+                               % ("else " if n else "", cstring(rest),
+                                  len(rest), i))
+                else:
+                    out.append("\t\tf = %d;\n" % i)
+            out.append("\t\tbreak;\n")
+        out.append("\t    }\n\t    break;\n")
+    out.append("\t}\n")
+    return "".join(out)
+
+
+def value_size(attr):
+    "Decode buffer size, mirroring the interpreter's maxlen rules."
+    if attr["type"] == "string":
+        maxlen = attr["len"] - 1
+    elif attr["type"] == "check":
+        maxlen = len(attr["check"].encode())
+    else:
+        return "JSON_VAL_MAX"
+    return "%d" % (maxlen + 1) if maxlen < JSON_VAL_MAX - 1 \
+        else "JSON_VAL_MAX"
+
+
+def emit_store(attr):
+    "Emit the quote check, conversion and store for one attribute."
+    typ, member = attr["type"], "out->" + field(attr)
+    out = []
+    if typ in ("string", "check"):
+        out.append("\t    if (!quoted)\n"
+                   "\t\treturn JSON_ERR_NONQSTRING;\n")
+    elif typ in ("integer", "uinteger", "short", "ushort", "real",
+                 "boolean"):
+        out.append("\t    if (quoted)\n"
+                   "\t\treturn JSON_ERR_QNONSTRING;\n")
+    if typ == "integer":
+        out.append("\t    %s = (int)strtol(vp, NULL, 10);\n" % member)
+    elif typ == "uinteger":
+        out.append("\t    %s = (unsigned int)(int)strtol(vp, NULL, 10);\n"
+                   % member)
+    elif typ == "short":
+        out.append("\t    %s = (short)(int)strtol(vp, NULL, 10);\n" % member)
+    elif typ == "ushort":
+        out.append("\t    %s = (unsigned short)(int)strtol(vp, NULL, 10);\n"
+                   % member)
+    elif typ == "real":
+        out.append("\t    %s = strtod(vp, NULL);\n" % member)
+    elif typ == "boolean":
+        out.append("\t    %s = (vlen == 4 && memcmp(vp, \"true\", 4) == 0)\n"
+                   "\t\t|| strtol(vp, NULL, 0) != 0;\n" % member)
+    elif typ == "character":
+        out.append("\t    if (vlen > 1)\n"
+                   "\t\treturn JSON_ERR_STRLONG;\n"
+                   "\t    %s = vlen > 0 ? vp[0] : '\\0';\n" % member)
+    elif typ == "string":
+        cl = attr["len"] - 1
+        out.append("\t    memset(%s, '\\0', %d);\n"
+                   "\t    memcpy(%s, vp, vlen < %d ? vlen : %d);\n"
+                   % (member, cl + 1, member, cl, cl))
+    elif typ == "check":
+        out.append("\t    if (strcmp(vp, %s) != 0)\n"
+                   "\t\treturn JSON_ERR_CHECKFAIL;\n"
+                   % cstring(attr["check"]))
+    return "".join(out)
+
+
+def emit_source(desc, base):
+    attrs = desc["attributes"]
+    named = [(i, a) for (i, a) in enumerate(attrs) if a["name"] != ""]
+    wildcard = [i for (i, a) in enumerate(attrs) if a["name"] == ""]
+    out = []
+    out.append("/* %s.c - generated by mjsongen.py, do not edit */\n\n"
+               % base)
+    out.append("#include <math.h>\n#include <stdlib.h>\n"
+               "#include <string.h>\n\n"
+               "#include \"mjson.h\"\n#include \"%s.h\"\n" % base)
+    out.append(runtime)
+    out.append("\nint %s(const char *cp, struct %s *out, const char **end)\n"
+               % (desc["function"], desc["struct"]))
+    out.append("{\n"
+               "    char valbuf[JSON_VAL_MAX + 1], keybuf[JSON_ATTR_MAX + 1];\n"
+               "    const char *kp, *vp = NULL;\n"
+               "    size_t klen, vlen = 0;\n"
+               "    bool quoted = false;\n"
+               "    int f, status;\n\n"
+               "    if (end != NULL)\n"
+               "\t*end = NULL;\n\n")
+    for attr in attrs:
+        typ = attr["type"]
+        if typ in ("check", "ignore") or attr.get("nodefault"):
+            continue
+        member = "out->" + field(attr)
+        if typ == "string":
+            out.append("    %s[0] = '\\0';\n" % member)
+        else:
+            out.append("    %s = %s;\n" % (member, attr.get("default", "0")))
+    out.append("\n"
+               "    while (gen_isspace(*cp))\n"
+               "\tcp++;\n"
+               "    if (*cp != '{') {\n"
+               "\tif (end != NULL)\n"
+               "\t    *end = cp;\n"
+               "\treturn JSON_ERR_OBSTART;\n"
+               "    }\n"
+               "    for (cp++;;) {\n"
+               "\twhile (gen_isspace(*cp))\n"
+               "\t    cp++;\n"
+               "\tif (*cp == '}')\n"
+               "\t    break;\n"
+               "\tif (*cp != '\"') {\n"
+               "\t    if (end != NULL)\n"
+               "\t\t*end = cp;\n"
+               "\t    return JSON_ERR_ATTRSTART;\n"
+               "\t}\n"
+               "\tkp = ++cp;\n"
+               "\tcp += strcspn(cp, \"\\\"\\\\\");\n"
+               "\tif (*cp == '\\0')\n"
+               "\t    return JSON_ERR_BADTRAIL;\n"
+               "\telse if (*cp == '\"')\n"
+               "\t    klen = (size_t)(cp++ - kp);\n"
+               "\telse {\n"
+               "\t    /* decode an escaped name as the interpreter does */\n"
+               "\t    cp = kp;\n"
+               "\t    status = gen_read_string(&cp, keybuf, JSON_ATTR_MAX - 1,\n"
+               "\t\t\t\t     &klen);\n"
+               "\t    if (status == JSON_ERR_STRLONG)\n"
+               "\t\treturn JSON_ERR_ATTRLEN;\n"
+               "\t    else if (status != 0)\n"
+               "\t\treturn status;\n"
+               "\t    kp = keybuf;\n"
+               "\t}\n\n"
+               "\tf = %d;\n" % (wildcard[0] if wildcard else -1))
+    if named:
+        out.append(emit_dispatch(named))
+    out.append("\tif (f < 0)\n"
+               "\t    return JSON_ERR_BADATTR;\n\n"
+               "\tswitch (f) {\n")
+    for (i, attr) in enumerate(attrs):
+        out.append("\tcase %d:\t/* %s */\n" % (i, attr["name"] or "*"))
+        out.append("\t    status = gen_read_value(&cp, valbuf, %s,\n"
+                   "\t\t\t\t    &vp, &vlen, &quoted);\n"
+                   "\t    if (status != 0)\n"
+                   "\t\treturn status;\n" % value_size(attr))
+        out.append(emit_store(attr))
+        out.append("\t    break;\n")
+    out.append("\t}\n\n"
+               "\twhile (gen_isspace(*cp))\n"
+               "\t    cp++;\n"
+               "\tif (*cp == '}')\n"
+               "\t    break;\n"
+               "\tif (*cp != ',') {\n"
+               "\t    if (end != NULL)\n"
+               "\t\t*end = cp;\n"
+               "\t    return JSON_ERR_BADTRAIL;\n"
+               "\t}\n"
+               "\tcp++;\n"
+               "    }\n\n"
+               "    /* in case there's another object following, consume "
+               "trailing WS */\n"
+               "    for (cp++; gen_isspace(*cp); cp++)\n"
+               "\tcontinue;\n"
+               "    if (end != NULL)\n"
+               "\t*end = cp;\n"
+               "    return 0;\n"
+               "}\n")
+    return "".join(out)
+
+
+def main():
+    try:
+        (options, arguments) = getopt.getopt(sys.argv[1:], "ho:")
+    except getopt.GetoptError as err:
+        fail(str(err))
+    base = None
+    for (switch, val) in options:
+        if switch == "-o":
+            base = val
+        elif switch == "-h":
+            sys.stdout.write(__doc__)
+            sys.exit(0)
+    if len(arguments) != 1:
+        sys.stderr.write(__doc__)
+        sys.exit(1)
+    desc = load(arguments[0])
+    if base is None:
+        base = arguments[0].rsplit(".", 1)[0]
+    with open(base + ".h", "w") as fp:
+        fp.write(emit_header(desc, base.rsplit("/", 1)[-1]))
+    with open(base + ".c", "w") as fp:
+        fp.write(emit_source(desc, base.rsplit("/", 1)[-1]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,385 @@
+/* test_gen.c - generated by mjsongen.py, do not edit */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mjson.h"
+#include "test_gen.h"
+
+/* classify as the interpreter does: the C locale, whatever is set */
+static bool gen_isspace(unsigned char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static bool gen_isdigit(unsigned char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool gen_isxdigit(unsigned char c)
+{
+    return gen_isdigit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+}
+
+static int gen_read_string(const char **cpp, char *dst, size_t size,
+			   size_t *lenp)
+/* decode a JSON string body exactly as json_read_object() does */
+{
+    const char *cp = *cpp;
+    size_t len = 0, run;
+    unsigned int u;
+    int n;
+
+    for (;;) {
+	run = strcspn(cp, "\"\\");
+	if (run > size - len)
+	    return JSON_ERR_STRLONG;
+	memcpy(dst + len, cp, run);
+	len += run;
+	cp += run;
+	if (*cp == '"')
+	    break;
+	else if (*cp == '\0')
+	    return JSON_ERR_BADSTRING;
+	if (len >= size)
+	    return JSON_ERR_STRLONG;
+	switch (*++cp) {
+	case 'b':
+	    dst[len++] = '\b';
+	    break;
+	case 'f':
+	    dst[len++] = '\f';
+	    break;
+	case 'n':
+	    dst[len++] = '\n';
+	    break;
+	case 'r':
+	    dst[len++] = '\r';
+	    break;
+	case 't':
+	    dst[len++] = '\t';
+	    break;
+	case 'u':
+	    for (n = 0, u = 0; n < 4 && gen_isxdigit(cp[1]); n++) {
+		++cp;
+		u = u * 16 + (unsigned int)(gen_isdigit(*cp)
+		    ? *cp - '0' : (*cp | 0x20) - 'a' + 10);
+	    }
+	    if (n != 4)
+		return JSON_ERR_BADSTRING;
+	    dst[len++] = (char)(unsigned char)u;
+	    break;
+	case '\0':
+	    return JSON_ERR_BADSTRING;
+	default:
+	    dst[len++] = *cp;
+	    break;
+	}
+	++cp;
+    }
+    dst[len] = '\0';
+    *cpp = cp + 1;
+    if (lenp != NULL)
+	*lenp = len;
+    return 0;
+}
+
+static int gen_read_value(const char **cpp, char *valbuf, size_t size,
+			  const char **vpp, size_t *vlenp, bool *quotedp)
+/*
+ * Collect one scalar value.  A quoted value is decoded into valbuf; a
+ * bare token is left in place and described by *vpp and *vlenp.
+ */
+{
+    const char *cp = *cpp;
+
+    while (gen_isspace(*cp) || *cp == ':')
+	cp++;
+    if (*cp == '[' || *cp == '{')
+	return JSON_ERR_NOARRAY;
+    if (*cp == '"') {
+	int status;
+
+	++cp;
+	status = gen_read_string(&cp, valbuf, size, NULL);
+	if (status != 0)
+	    return status;
+	*vpp = valbuf;
+	*vlenp = strlen(valbuf);
+	*quotedp = true;
+    } else {
+	*vpp = cp;
+	while (*cp != '\0' && !gen_isspace(*cp)
+	       && *cp != ',' && *cp != '}')
+	    cp++;
+	*vlenp = (size_t)(cp - *vpp);
+	if (*vlenp > JSON_VAL_MAX)
+	    return JSON_ERR_TOKLONG;
+	*quotedp = false;
+    }
+    *cpp = cp;
+    return 0;
+}
+
+int json_read_gentpv(const char *cp, struct gentpv_t *out, const char **end)
+{
+    char valbuf[JSON_VAL_MAX + 1], keybuf[JSON_ATTR_MAX + 1];
+    const char *kp, *vp = NULL;
+    size_t klen, vlen = 0;
+    bool quoted = false;
+    int f, status;
+
+    if (end != NULL)
+	*end = NULL;
+
+    out->device[0] = '\0';
+    out->mode = -1;
+    out->sats = 10;
+    out->pdop = 0;
+    out->hdop_x10 = 0;
+    out->lat = NAN;
+    out->lon = NAN;
+    out->used = 0;
+    out->flag = 'x';
+
+    while (gen_isspace(*cp))
+	cp++;
+    if (*cp != '{') {
+	if (end != NULL)
+	    *end = cp;
+	return JSON_ERR_OBSTART;
+    }
+    for (cp++;;) {
+	while (gen_isspace(*cp))
+	    cp++;
+	if (*cp == '}')
+	    break;
+	if (*cp != '"') {
+	    if (end != NULL)
+		*end = cp;
+	    return JSON_ERR_ATTRSTART;
+	}
+	kp = ++cp;
+	cp += strcspn(cp, "\"\\");
+	if (*cp == '\0')
+	    return JSON_ERR_BADTRAIL;
+	else if (*cp == '"')
+	    klen = (size_t)(cp++ - kp);
+	else {
+	    /* decode an escaped name as the interpreter does */
+	    cp = kp;
+	    status = gen_read_string(&cp, keybuf, JSON_ATTR_MAX - 1,
+				     &klen);
+	    if (status == JSON_ERR_STRLONG)
+		return JSON_ERR_ATTRLEN;
+	    else if (status != 0)
+		return status;
+	    kp = keybuf;
+	}
+
+	f = 12;
+	switch (klen) {
+	case 3:
+	    switch (kp[0]) {
+	    case 'a':
+		if (memcmp(kp + 1, "lt", 2) == 0)
+		    f = 9;
+		break;
+	    case 'l':
+		if (memcmp(kp + 1, "at", 2) == 0)
+		    f = 7;
+		else if (memcmp(kp + 1, "on", 2) == 0)
+		    f = 8;
+		break;
+	    }
+	    break;
+	case 4:
+	    switch (kp[0]) {
+	    case 'f':
+		if (memcmp(kp + 1, "lag", 3) == 0)
+		    f = 11;
+		break;
+	    case 'h':
+		if (memcmp(kp + 1, "dop", 3) == 0)
+		    f = 6;
+		break;
+	    case 'm':
+		if (memcmp(kp + 1, "ode", 3) == 0)
+		    f = 3;
+		break;
+	    case 'p':
+		if (memcmp(kp + 1, "dop", 3) == 0)
+		    f = 5;
+		break;
+	    case 's':
+		if (memcmp(kp + 1, "ats", 3) == 0)
+		    f = 4;
+		break;
+	    case 't':
+		if (memcmp(kp + 1, "ime", 3) == 0)
+		    f = 2;
+		break;
+	    case 'u':
+		if (memcmp(kp + 1, "sed", 3) == 0)
+		    f = 10;
+		break;
+	    }
+	    break;
+	case 5:
+	    switch (kp[0]) {
+	    case 'c':
+		if (memcmp(kp + 1, "lass", 4) == 0)
+		    f = 0;
+		break;
+	    }
+	    break;
+	case 6:
+	    switch (kp[0]) {
+	    case 'd':
+		if (memcmp(kp + 1, "evice", 5) == 0)
+		    f = 1;
+		break;
+	    }
+	    break;
+	}
+	if (f < 0)
+	    return JSON_ERR_BADATTR;
+
+	switch (f) {
+	case 0:	/* class */
+	    status = gen_read_value(&cp, valbuf, 4,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (!quoted)
+		return JSON_ERR_NONQSTRING;
+	    if (strcmp(vp, "TPV") != 0)
+		return JSON_ERR_CHECKFAIL;
+	    break;
+	case 1:	/* device */
+	    status = gen_read_value(&cp, valbuf, 16,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (!quoted)
+		return JSON_ERR_NONQSTRING;
+	    memset(out->device, '\0', 16);
+	    memcpy(out->device, vp, vlen < 15 ? vlen : 15);
+	    break;
+	case 2:	/* time */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    break;
+	case 3:	/* mode */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (quoted)
+		return JSON_ERR_QNONSTRING;
+	    out->mode = (int)strtol(vp, NULL, 10);
+	    break;
+	case 4:	/* sats */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (quoted)
+		return JSON_ERR_QNONSTRING;
+	    out->sats = (unsigned int)(int)strtol(vp, NULL, 10);
+	    break;
+	case 5:	/* pdop */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (quoted)
+		return JSON_ERR_QNONSTRING;
+	    out->pdop = (short)(int)strtol(vp, NULL, 10);
+	    break;
+	case 6:	/* hdop */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (quoted)
+		return JSON_ERR_QNONSTRING;
+	    out->hdop_x10 = (unsigned short)(int)strtol(vp, NULL, 10);
+	    break;
+	case 7:	/* lat */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (quoted)
+		return JSON_ERR_QNONSTRING;
+	    out->lat = strtod(vp, NULL);
+	    break;
+	case 8:	/* lon */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (quoted)
+		return JSON_ERR_QNONSTRING;
+	    out->lon = strtod(vp, NULL);
+	    break;
+	case 9:	/* alt */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (quoted)
+		return JSON_ERR_QNONSTRING;
+	    out->alt = strtod(vp, NULL);
+	    break;
+	case 10:	/* used */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (quoted)
+		return JSON_ERR_QNONSTRING;
+	    out->used = (vlen == 4 && memcmp(vp, "true", 4) == 0)
+		|| strtol(vp, NULL, 0) != 0;
+	    break;
+	case 11:	/* flag */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    if (vlen > 1)
+		return JSON_ERR_STRLONG;
+	    out->flag = vlen > 0 ? vp[0] : '\0';
+	    break;
+	case 12:	/* * */
+	    status = gen_read_value(&cp, valbuf, JSON_VAL_MAX,
+				    &vp, &vlen, &quoted);
+	    if (status != 0)
+		return status;
+	    break;
+	}
+
+	while (gen_isspace(*cp))
+	    cp++;
+	if (*cp == '}')
+	    break;
+	if (*cp != ',') {
+	    if (end != NULL)
+		*end = cp;
+	    return JSON_ERR_BADTRAIL;
+	}
+	cp++;
+    }
+
+    /* in case there's another object following, consume trailing WS */
+    for (cp++; gen_isspace(*cp); cp++)
+	continue;
+    if (end != NULL)
+	*end = cp;
+    return 0;
+}
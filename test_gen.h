@@ -0,0 +1,22 @@
+/* test_gen.h - generated by mjsongen.py, do not edit */
+#ifndef TEST_GEN_H
+#define TEST_GEN_H
+
+#include <stdbool.h>
+
+struct gentpv_t {
+    char device[16];
+    int mode;
+    unsigned int sats;
+    short pdop;
+    unsigned short hdop_x10;
+    double lat;
+    double lon;
+    double alt;
+    bool used;
+    char flag;
+};
+
+int json_read_gentpv(const char *, struct gentpv_t *, const char **);
+
+#endif /* TEST_GEN_H */
@@ -0,0 +1,58 @@
+/* test_inputs.h - messages shared by the specialised-parser tests
+ *
+ * test_mjsongen.c and test_mjson_hpp.cpp both run every entry through
+ * their parser and through json_read_object() with the equivalent
+ * template, and require the results to agree, so a new case added here
+ * is checked against the interpreter everywhere at once.
+ *
+ * This file is Copyright (c) 2026 by the microjson contributors
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#ifndef TEST_INPUTS_H
+#define TEST_INPUTS_H
+
+static const char *const test_inputs[] = {
+    /* gpsd TPV report with many attributes left to the wildcard */
+    "{\"class\":\"TPV\",\"device\":\"/dev/"
+    "ttyUSB0\",\"mode\":3,\"time\":\"2019-10-04T08:51:34.000Z\",\"ept\":0.005,"
+    "\"lat\":46.367303831,\"lon\":-116.963791235,\"altHAE\":460.834,\"altMSL\":"
+    "476.140,\"epx\":7.842,\"epy\":12.231,\"epv\":30.607,\"track\":57.1020,"
+    "\"eps\":24.46,\"epc\":61.21,\"velN\":0.035,\"velE\":0.055,\"sep\":31.273}",
+    "{\"class\":\"TPV\",\"mode\":-3,\"sats\":7,\"pdop\":-12,\"hdop\":65535,"
+    "\"alt\":1e3,\"used\":true,\"flag\":\"c\"}",
+    "  {  \"lon\" : 0x10 , \"used\" : 5 , \"lat\":-0.5e-2 }  {\"mode\":1}",
+    "{\"device\":\"tab\\there \\u0041\\\"\\/\"}",
+    "{\"device\":\"exactly 16 chars\"}",	/* truncated, not an error */
+    "{\"used\":false,\"flag\":z,\"mode\":2.9}",
+    "{}",
+    "{\"class\":\"TPV\",}",
+    /* errors */
+    "[1,2]",
+    "{\"class\":\"SKY\"}",
+    "{\"bogus\":1,\"mode\":2}",
+    "{\"device\":\"this one is too long\"}",
+    "{\"mode\":\"3\"}",
+    "{\"device\":3}",
+    "{\"class\":TPV}",
+    "{\"lat\":[1]}",
+    "{\"mode\":{\"a\":1}}",
+    "{\"flag\":\"ab\"}",
+    "{\"mode\":3 \"lat\":2}",
+    "{mode:3}",
+    "{\"an_attribute_name_longer_than_31_chars\":1}",	/* no limit */
+    "{\"device\":\"bad \\u12 escape\"}",
+    /* names with escapes match their decoded form */
+    "{\"\\u006dode\":5}",
+    "{\"mo\\u0064e\":3,\"l\\u0061t\":1.5,\"\\u0061\":2}",
+    "{\"cl\\u0061ss\":\"SKY\"}",
+    "{\"m\\u006fde\":\"3\"}",
+    "{\"\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061"
+    "\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061"
+    "\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061"
+    "\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061\\u0061\":1}",
+    "{\"mo\\u00",
+};
+
+#define TEST_NINPUTS	((int)(sizeof(test_inputs) / sizeof(test_inputs[0])))
+
+#endif /* TEST_INPUTS_H */
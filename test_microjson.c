@@ -14,6 +14,7 @@
 #include <math.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <math.h>
 #include <stddef.h>
 
@@ -725,6 +726,616 @@ static const char *json_end18;
 
 static const char *json_str18 = "{\"flag1\":1}{\"flag1\":0}{\"flag1\":7, \"flags4\":[1,0,7]} {\"flag2\":true, \"flags4\":[0,true,false]}";
 
+/* Case 19: Read booleans into packed bitsets */
+
+static const char *json_str19 = "{\"flags\":[true,false,1,0,true],\
+           \"sats\":[{\"used\":true},{\"used\":false},{\"used\":true}],\
+           \"ports\":[{\"enable\":true,\"raw\":false},{\"raw\":true}]}";
+
+static uint64_t flagbits[JSON_BITSET_WORDS(70)];
+static uint64_t usedbits[JSON_BITSET_WORDS(MAXCHANNELS)];
+static int flagbitcount, satcount19;
+
+struct portstruct_t {
+    uint64_t options[1];
+#define PORT_ENABLE	0
+#define PORT_RAW	1
+#define PORT_JSON	2
+};
+static struct portstruct_t ports[4];
+static int portcount;
+
+static const struct json_attr_t json_attrs_19_sats[] = {
+    {"used",   t_bitset, .addr.bitset = usedbits},
+    {NULL},
+};
+
+static const struct json_attr_t json_attrs_19_ports[] = {
+    {"enable", t_bitset, STRUCTBIT(struct portstruct_t, options, PORT_ENABLE)},
+    {"raw",    t_bitset, STRUCTBIT(struct portstruct_t, options, PORT_RAW)},
+    {"json",   t_bitset, STRUCTBIT(struct portstruct_t, options, PORT_JSON),
+                         .dflt.boolean = true},
+    {NULL},
+};
+
+static const struct json_attr_t json_attrs_19[] = {
+    {"flags", t_array, .addr.array.element_type = t_bitset,
+                       .addr.array.arr.bitsets.store = flagbits,
+                       .addr.array.count = &flagbitcount,
+                       .addr.array.maxlen = 70},
+    {"sats",  t_array, .addr.array.element_type = t_object,
+                       .addr.array.arr.objects.subtype = json_attrs_19_sats,
+                       .addr.array.count = &satcount19,
+                       .addr.array.maxlen = MAXCHANNELS},
+    {"ports", t_array, STRUCTARRAY(ports, json_attrs_19_ports, &portcount)},
+    {NULL},
+};
+
+/* Case 20: Numeric arrays must convert exactly as strtol/strtod would */
+
+static const char *json_str20i = "[0, 7, -42, 12345678, 987654321, "
+    "-123456789012, 0x1f, 010, +5, 4294967296]";
+static const char *json_str20r = "[0.5, -17.25, 1e5, 3.14159265358979, "
+    "1.0e-3, 123456789012345678, 2.5E+21, .5, -0.0, 1e400, 0x10]";
+static int intstore20[12];
+static double realstore20[12];
+static int intcount20, realcount20;
+
+static const struct json_array_t json_array_20i = {
+    .element_type = t_integer,
+    .arr.integers.store = intstore20,
+    .count = &intcount20,
+    .maxlen = 12,
+};
+
+static const struct json_array_t json_array_20r = {
+    .element_type = t_real,
+    .arr.reals.store = realstore20,
+    .count = &realcount20,
+    .maxlen = 12,
+};
+
+/* Case 21: Escapes in string values and string arrays */
+
+static const char *json_str21 = "{\"path\":\"C:\\\\dev\\/tty\\\"0\\\"\\n\",\
+           \"names\":[\"plain\",\"tab\\there\",\"\\u0041\\u0062c\",\"\"]}";
+
+static char path21[32];
+static char *nameptrs21[4];
+static char namestore21[32];
+static int namecount21;
+
+static const struct json_attr_t json_attrs_21[] = {
+    {"path",  t_string, .addr.string = path21, .len = sizeof(path21)},
+    {"names", t_array,  .addr.array.element_type = t_string,
+                        .addr.array.arr.strings.ptrs = nameptrs21,
+                        .addr.array.arr.strings.store = namestore21,
+                        .addr.array.arr.strings.storelen = sizeof(namestore21),
+                        .addr.array.count = &namecount21,
+                        .addr.array.maxlen = 4},
+    {NULL},
+};
+
+/* Case 22: Unpack an object array into columns, strings included */
+
+static const char *json_str22 = "{\"satellites\":[\
+           {\"PRN\":10,\"ss\":34.5,\"gnss\":\"GP\",\"used\":true},\
+           {\"PRN\":29,\"ss\":40,\"gnss\":\"GLO\"},\
+           {\"PRN\":8,\"ss\":41.25,\"gnss\":\"GA\",\"used\":true}]}";
+
+struct satcolumns_t {
+    int PRN[MAXCHANNELS];
+    double ss[MAXCHANNELS];
+    char gnss[MAXCHANNELS][4];
+    uint64_t used[JSON_BITSET_WORDS(MAXCHANNELS)];
+};
+static struct satcolumns_t satcolumns;
+static int satcount22;
+
+static const struct json_attr_t json_attrs_22_sats[] = {
+    {"PRN",   t_integer, STRUCTOBJECT(struct satcolumns_t, PRN)},
+    {"ss",    t_real,    STRUCTOBJECT(struct satcolumns_t, ss)},
+    {"gnss",  t_string,  STRUCTOBJECT(struct satcolumns_t, gnss),
+                         .len = sizeof(satcolumns.gnss[0])},
+    {"used",  t_bitset,  STRUCTOBJECT(struct satcolumns_t, used)},
+    {NULL},
+};
+
+static const struct json_attr_t json_attrs_22[] = {
+    {"satellites", t_array, COLUMNARRAY(satcolumns, json_attrs_22_sats,
+                                        &satcount22, MAXCHANNELS)},
+    {NULL},
+};
+
+/* Case 23: Report which attributes were present in the input */
+
+static const char *json_str23 = "{\"flag2\":false,\"dftreal\":1.5,\
+           \"parts\":[{\"name\":\"Urgle\",\"count\":3},{\"flag\":true}]}";
+
+static uint64_t present23[JSON_BITSET_WORDS(6)];
+static uint64_t partpresent23[5][JSON_BITSET_WORDS(3)];
+
+static const struct json_attr_t json_attrs_23[] = {
+    {"dftint",  t_integer, .addr.integer = &dftinteger, .dflt.integer = -5},
+    {"dftuint", t_integer, .addr.uinteger = &dftuinteger, .dflt.uinteger = 10},
+    {"dftreal", t_real,    .addr.real = &dftreal,       .dflt.real = 23.17},
+    {"flag1",   t_boolean, .addr.boolean = &flag1,},
+    {"flag2",   t_boolean, .addr.boolean = &flag2,},
+    {"parts",   t_array, STRUCTARRAY(dumbstruck, json_attrs_6_subtype,
+                                     &dumbcount),
+                         .addr.array.arr.objects.present = partpresent23[0]},
+    {NULL},
+};
+
+static const struct json_options_t json_options_23 = {
+    .present = present23,
+};
+
+/* Case 24: Stop parsing once the wanted attributes have been seen */
+
+static const char *json_str24 = "{\"class\":\"TPV\",\"device\":\"GPS#1\",\
+    \"lat\":7.5,\"lon\":46.25,\"alt\":\"not a number\",\
+    \"junk\":{\"a\":[1,{\"b\":\"}]\\\"\"}]},\"mode\":3} {\"class\":\"TPV\"}";
+
+static double lat24, lon24, alt24;
+static int mode24;
+static uint64_t present24[1], required24[1] = {0x7};
+
+static const struct json_attr_t json_attrs_24[] = {
+    {"class", t_check,   .dflt.check = "TPV"},
+    {"lat",   t_real,    .addr.real = &lat24, .dflt.real = NAN},
+    {"lon",   t_real,    .addr.real = &lon24, .dflt.real = NAN},
+    {"alt",   t_real,    .addr.real = &alt24, .dflt.real = -1},
+    {"mode",  t_integer, .addr.integer = &mode24, .dflt.integer = -1},
+    {.attribute = "", .type = t_ignore},
+    {NULL},
+};
+
+/* Case 25: Convert only the attributes selected for this call */
+
+static const char *json_str25 = "{\"class\":\"TPV\",\"device\":\"GPS#1\",\
+    \"lat\":7.5,\"lon\":46.25,\"alt\":12,\"junk\":\"x\",\"mode\":3}";
+
+static const uint64_t select25[1] = {0x13};	/* class, lat, mode */
+static const uint64_t select25_nocheck[1] = {0x12};	/* lat, mode */
+
+/* deselection skips storage, not checking, so these fail either way */
+static const struct {
+    const char *input;
+    const uint64_t *select;
+    int status;
+} errors25[] = {
+    {"{\"lat\":1,\"alt\":\"not a number\"}", select25, JSON_ERR_QNONSTRING},
+    {"{\"lat\":1,\"lon\":[1,2]}", select25, JSON_ERR_NOARRAY},
+    {"{\"junk\":{\"a\":1}}", select25, JSON_ERR_NOARRAY},
+    {"{\"class\":\"SKY\"}", select25_nocheck, JSON_ERR_CHECKFAIL},
+};
+
+/* Case 27: Index a message once, bind it to two templates */
+
+static struct json_token_t tokens27[32];
+
+struct sat27_t {
+    int PRN;
+    double ss;
+    char gnss[4];
+    bool used;
+};
+static struct sat27_t sats27[MAXCHANNELS];
+static int satcount27;
+
+static const struct json_attr_t json_attrs_27_sats[] = {
+    {"PRN",  t_integer, STRUCTOBJECT(struct sat27_t, PRN)},
+    {"ss",   t_real,    STRUCTOBJECT(struct sat27_t, ss)},
+    {"gnss", t_string,  STRUCTOBJECT(struct sat27_t, gnss),
+                        .len = sizeof(sats27[0].gnss)},
+    {"used", t_boolean, STRUCTOBJECT(struct sat27_t, used)},
+    {NULL},
+};
+
+static const struct json_attr_t json_attrs_27[] = {
+    {"satellites", t_array, STRUCTARRAY(sats27, json_attrs_27_sats,
+                                        &satcount27)},
+    {NULL},
+};
+
+/* Case 28: Tokenize without a template, resuming when the array fills */
+
+static struct json_token_t tokens28[16];
+
+/* Case 29: Skip parsing a message already held in the targets */
+
+static const char *json_str29 = "{\"class\":\"TPV\",\"lat\":7.5,\"mode\":3} \
+{\"class\":\"TPV\",\"mode\":2}";
+
+static struct json_cache_entry_t entries29[4];
+static const uint64_t select29 = ~(uint64_t)0;
+static struct json_cache_t cache29 = {
+    .entries = entries29,
+    .nentries = 4,
+};
+
+static struct json_cache_entry_t entries29b[2];
+static char text29[2 * 64];
+static struct json_cache_t cache29b = {
+    .entries = entries29b,
+    .nentries = 2,
+    .text = text29,
+    .textsize = sizeof(text29),
+};
+
+/* Case 30: A compiled template agrees with the interpreter */
+
+#define JIT_IMAGE30	256
+
+static size_t jit_target30(const struct json_attr_t *cursor, char **lptr)
+/* where a scalar entry stores, and how much */
+{
+    switch (cursor->type) {
+    case t_integer:
+    case t_uinteger:
+	*lptr = (char *)cursor->addr.integer;
+	return sizeof(int);
+    case t_short:
+    case t_ushort:
+	*lptr = (char *)cursor->addr.shortint;
+	return sizeof(short);
+    case t_real:
+	*lptr = (char *)cursor->addr.real;
+	return sizeof(double);
+    case t_boolean:
+	*lptr = (char *)cursor->addr.boolean;
+	return sizeof(bool);
+    case t_character:
+	*lptr = cursor->addr.character;
+	return 1;
+    case t_string:
+	*lptr = cursor->addr.string;
+	return cursor->len;
+    default:
+	return 0;
+    }
+}
+
+static int jit_run30(const struct json_jit_t *jit, bool compiled,
+		     const char *input, const char **end, char *image)
+/* parse from a known starting image, then snapshot the targets */
+{
+    const struct json_attr_t *cursor;
+    char *lptr;
+    size_t len, n = 0;
+    int status;
+
+    for (cursor = jit->attrs; cursor->attribute != NULL; cursor++)
+	if ((len = jit_target30(cursor, &lptr)) > 0)
+	    (void)memset(lptr, 0x55, len);
+    if (compiled)
+	status = json_jit_read(jit, input, end);
+    else
+	status = json_read_object(input, jit->attrs, end);
+    (void)memset(image, '\0', JIT_IMAGE30);
+    for (cursor = jit->attrs; cursor->attribute != NULL; cursor++)
+	if ((len = jit_target30(cursor, &lptr)) > 0) {
+	    assert(n + len <= JIT_IMAGE30);
+	    (void)memcpy(image + n, lptr, len);
+	    n += len;
+	}
+    return status;
+}
+
+static void jit_agrees30(const char *input, const struct json_attr_t *attrs,
+			 bool compiles)
+{
+    struct json_jit_t jit;
+    char image[2][JIT_IMAGE30];
+    const char *end[2];
+    int status[2];
+    bool compiled = json_jit_compile(attrs, &jit);
+
+#if defined(JIT_ENABLE) && defined(__x86_64__) && defined(__linux__)
+    assert_boolean("compiled", compiled, compiles);
+#else
+    (void)compiles;
+    assert_boolean("compiled", compiled, false);
+#endif
+    status[0] = jit_run30(&jit, false, input, &end[0], image[0]);
+    status[1] = jit_run30(&jit, true, input, &end[1], image[1]);
+    json_jit_free(&jit);
+    assert_integer("status", status[1], status[0]);
+    if (status[0] == 0)
+	assert_boolean("end", end[1] == end[0], true);
+    assert_boolean("targets", memcmp(image[0], image[1], JIT_IMAGE30) == 0,
+		   true);
+}
+
+/* Case 31: Variable-length strings from a caller-supplied arena */
+
+static const char *json_str31 = "{\"devices\":[\
+           {\"path\":\"/dev/ttyUSB0\",\"driver\":\"u-blox\",\"bps\":9600},\
+           {\"path\":\"/dev/pps0\",\"bps\":0},\
+           {\"path\":\"tcp://localhost:2947/\\u0041\",\"driver\":\"\"}]}";
+
+struct device31_t {
+    struct json_string_t path, driver;
+    int bps;
+};
+static struct device31_t devices31[4];
+static int devcount31;
+static char store31[64];
+static struct json_arena_t arena31 = {
+    .base = store31,
+    .size = sizeof(store31),
+};
+
+static const struct json_attr_t json_attrs_31_device[] = {
+    {"path",   t_arenastring, STRUCTASTRING(struct device31_t, path,
+                                            &arena31)},
+    {"driver", t_arenastring, STRUCTASTRING(struct device31_t, driver,
+                                            &arena31)},
+    {"bps",    t_integer,     STRUCTOBJECT(struct device31_t, bps)},
+    {NULL},
+};
+
+static const struct json_attr_t json_attrs_31[] = {
+    {"devices", t_array, STRUCTARRAY(devices31, json_attrs_31_device,
+                                     &devcount31)},
+    {NULL},
+};
+
+/* Case 33: Nesting deeper than the frame stack is refused */
+
+static struct json_frame_t frames33[3];
+
+/* Case 34: The lexer's token kind picks among same-name specs */
+
+static unsigned int uint34;
+static int int34;
+static double real34;
+static bool bool34;
+static char str34[8];
+
+static const struct json_attr_t json_attrs_34[] = {
+    {"v", t_uinteger, .addr.uinteger = &uint34},
+    {"v", t_integer,  .addr.integer = &int34},
+    {"v", t_real,     .addr.real = &real34},
+    {"v", t_boolean,  .addr.boolean = &bool34},
+    {"v", t_string,   .addr.string = str34, .len = sizeof(str34)},
+    {NULL},
+};
+
+/* Case 35: Predict the key order from the previous message */
+
+static const char *json_str35 = "{\"class\":\"TPV\",\"mode\":3,\
+\"lat\":7.5,\"lon\":46.25}";
+static const char *json_str35_shuffled = "{\"lon\":-1,\"class\":\"TPV\",\
+\"lat\":2,\"mode\":1}";
+
+static int mode35;
+static double lat35, lon35;
+
+static const struct json_attr_t json_attrs_35[] = {
+    {"class", t_check,   .dflt.check = "TPV"},
+    {"lat",   t_real,    .addr.real = &lat35},
+    {"lon",   t_real,    .addr.real = &lon35},
+    {"mode",  t_integer, .addr.integer = &mode35},
+    {NULL},
+};
+
+static struct json_order_slot_t slots35[5];
+static struct json_order_t order35 = {
+    .slots = slots35,
+    .nslots = 5,
+};
+
+/* Case 36: Keys are matched in place, whatever their length */
+
+static const char *json_str36 = "{\"a_key_well_over_thirty_one_characters\":36,\
+\"esc\\u0061ped\":true}";
+
+static int long36;
+static bool escaped36;
+
+static const struct json_attr_t json_attrs_36[] = {
+    {"a_key_well_over_thirty_one_characters", t_integer,
+                                          .addr.integer = &long36},
+    {"escaped", t_boolean, .addr.boolean = &escaped36},
+    {NULL},
+};
+
+static struct json_token_t tokens36[8];
+
+/* Case 37: Apply partial updates onto existing state */
+
+static const char *json_str37 = "{\"mode\":3,\"satellites\":[\
+{\"PRN\":5,\"az\":10,\"used\":true},{\"PRN\":7,\"az\":20}]}";
+static const char *json_str37_update = "{\"satellites\":[\
+{\"used\":true,\"PRN\":7},{\"PRN\":9,\"az\":30}]}";
+static const char *json_str37_repeat = "{\"satellites\":[\
+{\"PRN\":12,\"az\":1},{\"PRN\":11,\"az\":2},{\"PRN\":12,\"az\":3}]}";
+
+struct sat37_t {
+    int prn;
+    double az;
+    bool used;
+};
+
+static int mode37, nsats37;
+static struct sat37_t sats37[4];
+static char journalbuf37[512];
+
+static const struct json_attr_t json_attrs_37_sat[] = {
+    {"PRN",  t_integer, STRUCTOBJECT(struct sat37_t, prn)},
+    {"az",   t_real,    STRUCTOBJECT(struct sat37_t, az), .dflt.real = -1},
+    {"used", t_boolean, STRUCTOBJECT(struct sat37_t, used)},
+    {NULL},
+};
+
+static const struct json_attr_t json_attrs_37[] = {
+    {"mode",       t_integer, .addr.integer = &mode37, .dflt.integer = -1},
+    {"satellites", t_array,   STRUCTARRAY(sats37, json_attrs_37_sat,
+                                          &nsats37),
+                              .addr.array.arr.objects.key = "PRN"},
+    {NULL},
+};
+
+/* the same, with elements matched by position */
+static const struct json_attr_t json_attrs_37_byindex[] = {
+    {"mode",       t_integer, .addr.integer = &mode37, .dflt.integer = -1},
+    {"satellites", t_array,   STRUCTARRAY(sats37, json_attrs_37_sat,
+                                          &nsats37)},
+    {NULL},
+};
+
+/* keyed by a member the subtype doesn't have */
+static const struct json_attr_t json_attrs_37_badkey[] = {
+    {"satellites", t_array,   STRUCTARRAY(sats37, json_attrs_37_sat,
+                                          &nsats37),
+                              .addr.array.arr.objects.key = "prn"},
+    {NULL},
+};
+
+/* keyed by a string that fills, and so is truncated in, its member */
+struct dev37_t {
+    char name[4];
+    int bps;
+};
+
+static int ndevs37;
+static struct dev37_t devs37[2];
+
+static const struct json_attr_t json_attrs_37_dev[] = {
+    {"name", t_string,  STRUCTOBJECT(struct dev37_t, name),
+                        .len = sizeof(devs37[0].name)},
+    {"bps",  t_integer, STRUCTOBJECT(struct dev37_t, bps)},
+    {NULL},
+};
+
+static const struct json_attr_t json_attrs_37_devs[] = {
+    {"devices", t_array, STRUCTARRAY(devs37, json_attrs_37_dev, &ndevs37),
+                         .addr.array.arr.objects.key = "name"},
+    {NULL},
+};
+
+/* a scalar array, which an update can only extend by position */
+static int levels37[4], nlevels37;
+
+static const struct json_attr_t json_attrs_37_levels[] = {
+    {"levels", t_array, .addr.array.element_type = t_integer,
+                        .addr.array.arr.integers.store = levels37,
+                        .addr.array.count = &nlevels37,
+                        .addr.array.maxlen = 4},
+    {NULL},
+};
+
+/* Case 38: A journal keeps a failed parse away from the targets */
+
+static const char *json_str38 = "{\"mode\":3,\"tag\":\"GPS#1\",\
+\"satellites\":[{\"PRN\":5,\"az\":10},{\"PRN\":7,\"az\":20}],\
+\"levels\":[1,2,3]}";
+static const char *json_str38_bad = "{\"mode\":2,\"tag\":\"GPS#2\",\
+\"satellites\":[{\"PRN\":8,\"az\":40}],\"levels\":[4,x]}";
+
+static int mode38, nsats38, levels38[4], nlevels38;
+static struct sat37_t sats38[4];
+static char arenabuf38[16];
+static struct json_arena_t arena38 = {arenabuf38, sizeof(arenabuf38), 0};
+static struct json_string_t tag38;
+static char journalbuf38[1024];
+
+static const struct json_attr_t json_attrs_38[] = {
+    {"mode",       t_integer,     .addr.integer = &mode38},
+    {"tag",        t_arenastring, .addr.astring.target.store = &tag38,
+                                  .addr.astring.arena = &arena38},
+    {"satellites", t_array,       STRUCTARRAY(sats38, json_attrs_37_sat,
+                                              &nsats38)},
+    {"levels",     t_array,       .addr.array.element_type = t_integer,
+                                  .addr.array.arr.integers.store = levels38,
+                                  .addr.array.count = &nlevels38,
+                                  .addr.array.maxlen = 4},
+    {NULL},
+};
+
+/* Case 39: Validate a message without storing it */
+
+static const char *json_str39_long = "{\"tag\":\"GPS#1\",\
+\"satellites\":[{\"PRN\":5},{\"PRN\":6},{\"PRN\":7},{\"PRN\":8},\
+{\"PRN\":9}]}";
+
+/* a datagram with no NUL, followed in memory by more whitespace */
+static const struct {
+    char msg[12];
+    char next[8];
+} json_dgram39 = {"{\"mode\":3}  ", "   [1]"};
+
+/* Case 40: Arrays consumed one element at a time */
+
+static const char *json_str40 = "{\"levels\":[1,2,3,4,5,6,7,8,9,10],\
+\"satellites\":[{\"PRN\":5,\"az\":10},{\"PRN\":7},{\"PRN\":9,\"az\":30}],\
+\"names\":[\"alpha\",\"beta\",\"gamma\"]}";
+
+static int level40, nlevels40, nsats40, nnames40, levelsum40, prnsum40;
+static struct sat37_t sat40;
+static char *nameptrs40[1];
+static char namestore40[8], names40[32];
+static double azsum40;
+
+static int sum_levels40(const struct json_array_t *arr, int i, void *arg)
+{
+    (void)i;
+    *(int *)arg += arr->arr.integers.store[0];
+    return 0;
+}
+
+static int sum_sats40(const struct json_array_t *arr, int i, void *arg)
+{
+    const struct sat37_t *sat = (const struct sat37_t *)arr->arr.objects.base;
+
+    (void)i;
+    (void)arg;
+    prnsum40 += sat->prn;
+    azsum40 += sat->az;
+    return 0;
+}
+
+static int join_names40(const struct json_array_t *arr, int i, void *arg)
+{
+    (void)arg;
+    if (i > 0)
+	(void)strncat(names40, ",", sizeof(names40) - strlen(names40) - 1);
+    (void)strncat(names40, arr->arr.strings.ptrs[0],
+		  sizeof(names40) - strlen(names40) - 1);
+    /* stop at the third name */
+    return i == 2 ? JSON_ERR_SUBTOOLONG : 0;
+}
+
+static const struct json_attr_t json_attrs_40[] = {
+    {"levels",     t_array,   .addr.array.element_type = t_integer,
+                              .addr.array.arr.integers.store = &level40,
+                              .addr.array.count = &nlevels40,
+                              .addr.array.maxlen = 1,
+                              .addr.array.callback = sum_levels40,
+                              .addr.array.arg = &levelsum40},
+    {"satellites", t_array,   .addr.array.element_type = t_structobject,
+                              .addr.array.arr.objects.subtype =
+                                  json_attrs_37_sat,
+                              .addr.array.arr.objects.base = (char *)&sat40,
+                              .addr.array.arr.objects.stride = sizeof(sat40),
+                              .addr.array.count = &nsats40,
+                              .addr.array.maxlen = 1,
+                              .addr.array.callback = sum_sats40},
+    {"names",      t_array,   .addr.array.element_type = t_string,
+                              .addr.array.arr.strings.ptrs = nameptrs40,
+                              .addr.array.arr.strings.store = namestore40,
+                              .addr.array.arr.strings.storelen =
+                                  sizeof(namestore40),
+                              .addr.array.count = &nnames40,
+                              .addr.array.maxlen = 1,
+                              .addr.array.callback = join_names40},
+    {NULL},
+};
+
+static struct json_token_t tokens40[40];
+
 /* Insert more test definitions here */
 /* *INDENT-ON* */
 
@@ -735,6 +1346,9 @@ static void jsontest(int i)
     switch (i) 
     {
     case 1:
+	/* a check entry has no target address, but is still enforced */
+	status = json_tpv_read("{\"class\":\"SKY\"}", &gpsdata, NULL);
+	assert_error_case(i, status, JSON_ERR_CHECKFAIL);
 	status = libgps_json_unpack(json_str1, &gpsdata, NULL);
 	assert_case(i, status);
 	assert_string("device", gpsdata.dev.path, "GPS#1");
@@ -924,7 +1538,806 @@ static void jsontest(int i)
 	assert_boolean("flags4[2]", flags4[2], false);
 	break;
 
-#define MAXTEST 18
+    case 19:
+	flagbits[0] = flagbits[1] = ~(uint64_t)0;
+	status = json_read_object(json_str19, json_attrs_19, NULL);
+	assert_case(i, status);
+	assert_integer("flagbitcount", flagbitcount, 5);
+	assert_integer("flagbits[0]", (int)(flagbits[0] & 0x1f), 0x15);
+	/* bits past the count are cleared, up to maxlen */
+	assert_boolean("flagbits[5]", JSON_BITSET_TEST(flagbits, 5), false);
+	assert_boolean("flagbits[1]", flagbits[1] == 0, true);
+	assert_integer("satcount", satcount19, 3);
+	assert_integer("usedbits[0]", (int)usedbits[0], 0x5);
+	assert_integer("portcount", portcount, 2);
+	assert_integer("ports[0].options", (int)ports[0].options[0], 0x5);
+	assert_integer("ports[1].options", (int)ports[1].options[0], 0x6);
+	/* a short array after a long one leaves only its own bits */
+	status = json_read_object("{\"flags\":[false,true]}", json_attrs_19,
+				  NULL);
+	assert_case(i, status);
+	assert_integer("flagbitcount", flagbitcount, 2);
+	assert_boolean("flagbits[0]", flagbits[0] == 0x2, true);
+	break;
+
+    case 20:
+	status = json_read_array(json_str20i, &json_array_20i, NULL);
+	assert_case(i, status);
+	assert_integer("count", intcount20, 10);
+	{
+	    const char *cp = json_str20i + 1;
+	    char *ep;
+	    int n;
+
+	    for (n = 0; n < intcount20; n++, cp = ep + 1)
+		assert_integer("intstore", intstore20[n],
+			       (int)strtol(cp, &ep, 0));
+	}
+	status = json_read_array(json_str20r, &json_array_20r, NULL);
+	assert_case(i, status);
+	assert_integer("count", realcount20, 11);
+	{
+	    const char *cp = json_str20r + 1;
+	    char *ep;
+	    int n;
+
+	    for (n = 0; n < realcount20; n++, cp = ep + 1)
+		assert_real("realstore", realstore20[n], strtod(cp, &ep));
+	}
+	assert_boolean("signbit", signbit(realstore20[8]) != 0, true);
+	break;
+
+    case 21:
+	status = json_read_object(json_str21, json_attrs_21, NULL);
+	assert_case(i, status);
+	assert_string("path", path21, "C:\\dev/tty\"0\"\n");
+	assert_integer("namecount", namecount21, 4);
+	assert_string("names[0]", nameptrs21[0], "plain");
+	assert_string("names[1]", nameptrs21[1], "tab\there");
+	assert_string("names[2]", nameptrs21[2], "Abc");
+	assert_string("names[3]", nameptrs21[3], "");
+	/* store overflow and unterminated strings are still caught */
+	status = json_read_array("[\"0123456789abcdef0123456789abcdef\"]",
+				 &json_attrs_21[1].addr.array, NULL);
+	assert_error_case(i, status, JSON_ERR_BADSTRING);
+	status = json_read_object("{\"path\":\"open", json_attrs_21, NULL);
+	assert_error_case(i, status, JSON_ERR_BADSTRING);
+	status = 0;
+	break;
+
+    case 22:
+	status = json_read_object(json_str22, json_attrs_22, NULL);
+	assert_case(i, status);
+	assert_integer("satcount", satcount22, 3);
+	assert_integer("PRN[0]", satcolumns.PRN[0], 10);
+	assert_integer("PRN[1]", satcolumns.PRN[1], 29);
+	assert_integer("PRN[2]", satcolumns.PRN[2], 8);
+	assert_real("ss[0]", satcolumns.ss[0], 34.5);
+	assert_real("ss[2]", satcolumns.ss[2], 41.25);
+	assert_string("gnss[0]", satcolumns.gnss[0], "GP");
+	assert_string("gnss[1]", satcolumns.gnss[1], "GLO");
+	assert_string("gnss[2]", satcolumns.gnss[2], "GA");
+	assert_integer("used", (int)satcolumns.used[0], 0x5);
+	break;
+
+    case 23:
+	present23[0] = ~(uint64_t)0;
+	status = json_read_object_opts(json_str23, json_attrs_23,
+				       &json_options_23, NULL);
+	assert_case(i, status);
+	assert_integer("present", (int)present23[0], 0x34);
+	assert_integer("dumbcount", dumbcount, 2);
+	assert_integer("parts[0]", (int)partpresent23[0][0], 0x5);
+	assert_integer("parts[1]", (int)partpresent23[1][0], 0x2);
+	assert_real("dftreal", dftreal, 1.5);
+	assert_integer("dftint", dftinteger, -5);
+	break;
+
+    case 24:
+	{
+	    struct json_options_t opts = {
+		.present = present24,
+		.required = required24,
+	    };
+	    const char *end;
+
+	    status = json_read_object_opts(json_str24, json_attrs_24,
+					   &opts, &end);
+	    assert_case(i, status);
+	    assert_real("lat", lat24, 7.5);
+	    assert_real("lon", lon24, 46.25);
+	    assert_real("alt", alt24, -1);
+	    assert_integer("mode", mode24, -1);
+	    assert_string("end", (char *)end, "{\"class\":\"TPV\"}");
+
+	    opts.return_early = true;
+	    status = json_read_object_opts(json_str24, json_attrs_24,
+					   &opts, &end);
+	    assert_case(i, status);
+	    assert_integer("end", *end, ',');
+	    assert_integer("present", (int)present24[0], 0x27);
+
+	    opts.present = NULL;
+	    status = json_read_object_opts(json_str24, json_attrs_24,
+					   &opts, &end);
+	    assert_error_case(i, status, JSON_ERR_NULLPTR);
+	    status = 0;
+	}
+	break;
+
+    case 25:
+	{
+	    struct json_options_t opts = {
+		.present = present24,
+		.select = select25,
+	    };
+
+	    size_t n;
+
+	    for (n = 0; n < sizeof(errors25) / sizeof(errors25[0]); n++) {
+		status = json_read_object(errors25[n].input, json_attrs_24,
+					  NULL);
+		assert_error_case(i, status, errors25[n].status);
+		opts.select = errors25[n].select;
+		status = json_read_object_opts(errors25[n].input,
+					       json_attrs_24, &opts, NULL);
+		assert_error_case(i, status, errors25[n].status);
+	    }
+	    opts.select = select25;
+	    lon24 = alt24 = 99;
+	    status = json_read_object_opts(json_str25, json_attrs_24,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    assert_real("lat", lat24, 7.5);
+	    assert_integer("mode", mode24, 3);
+	    assert_real("lon", lon24, 99);	/* neither parsed nor defaulted */
+	    assert_real("alt", alt24, 99);
+	    assert_integer("present", (int)present24[0], 0x3f);
+	}
+	break;
+
+    case 26:
+	/* template-free queries against earlier test inputs */
+	{
+	    char class[16];
+	    int prn;
+	    unsigned int az;
+	    double ss;
+	    bool used;
+	    size_t len2 = strlen(json_str2);
+
+	    status = json_get_string(json_str2, len2, "class",
+				     class, sizeof(class));
+	    assert_case(i, status);
+	    assert_string("class", class, "SKY");
+	    status = json_get_integer(json_str2, len2, "satellites[1].PRN",
+				      &prn);
+	    assert_case(i, status);
+	    assert_integer("PRN", prn, 29);
+	    status = json_get_uinteger(json_str2, len2, "satellites[6].az",
+				       &az);
+	    assert_case(i, status);
+	    assert_uinteger("az", az, 301);
+	    status = json_get_real(json_str2, len2, "satellites[3].ss", &ss);
+	    assert_case(i, status);
+	    assert_real("ss", ss, 43);
+	    status = json_get_boolean(json_str2, len2, "satellites[6].used",
+				      &used);
+	    assert_case(i, status);
+	    assert_boolean("used", used, false);
+	    status = json_get_integer(json_str2, len2, "satellites[7].PRN",
+				      &prn);
+	    assert_error_case(i, status, JSON_ERR_NOTFOUND);
+	    status = json_get_integer(json_str2, len2, "satellites[x]", &prn);
+	    assert_error_case(i, status, JSON_ERR_BADPATH);
+	    status = json_get_integer(json_str2, len2, "satellites[+1].PRN",
+				      &prn);
+	    assert_error_case(i, status, JSON_ERR_BADPATH);
+	    status = json_get_integer(json_str2, len2, "satellites[ 1].PRN",
+				      &prn);
+	    assert_error_case(i, status, JSON_ERR_BADPATH);
+	    status = json_get_integer(json_str2, len2, "satellites[-1].PRN",
+				      &prn);
+	    assert_error_case(i, status, JSON_ERR_BADPATH);
+	    /* numbers are decimal, as json_read_object() reads them */
+	    status = json_get_integer("{\"n\":010}", 10, "n", &prn);
+	    assert_case(i, status);
+	    assert_integer("n", prn, 10);
+	    status = json_get_uinteger("{\"n\":0x10}", 11, "n", &az);
+	    assert_error_case(i, status, JSON_ERR_BADNUM);
+	    /* an escaped member name matches its decoded path segment */
+	    status = json_get_integer("{\"a\\u0062\":3}", 13, "ab", &prn);
+	    assert_case(i, status);
+	    assert_integer("ab", prn, 3);
+	    status = json_get_integer(json_str2, len2, "class", &prn);
+	    assert_error_case(i, status, JSON_ERR_QNONSTRING);
+	    /* nothing past the stated length is looked at */
+	    status = json_get_integer(json_str2, 60, "satellites[1].PRN",
+				      &prn);
+	    assert_error_case(i, status, JSON_ERR_BADSUBTRAIL);
+	    status = json_get_string(json_str21, strlen(json_str21),
+				     "names[1]", class, sizeof(class));
+	    assert_case(i, status);
+	    assert_string("names[1]", class, "tab\there");
+#ifdef TIME_ENABLE
+	    status = json_get_time(json_str1, sizeof(json_str1) - 1, "time",
+				   &ss);
+	    assert_case(i, status);
+	    assert_real("time", ss, 1119183162.030000);
+#endif /* TIME_ENABLE */
+	}
+	break;
+
+    case 27:
+	{
+	    struct json_index_t ix = {
+		.tokens = tokens27,
+		.maxtokens = 32,
+	    };
+
+	    status = json_index(json_str22, &ix, NULL);
+	    assert_case(i, status);
+	    assert_integer("ntokens", ix.ntokens, 28);
+	    (void)memset(&satcolumns, '\0', sizeof(satcolumns));
+	    status = json_read_object_index(&ix, json_attrs_22);
+	    assert_case(i, status);
+	    assert_integer("satcount", satcount22, 3);
+	    assert_integer("PRN[2]", satcolumns.PRN[2], 8);
+	    assert_string("gnss[1]", satcolumns.gnss[1], "GLO");
+	    assert_integer("used", (int)satcolumns.used[0], 0x5);
+	    status = json_read_object_index(&ix, json_attrs_27);
+	    assert_case(i, status);
+	    assert_integer("satcount", satcount27, 3);
+	    assert_integer("PRN[1]", sats27[1].PRN, 29);
+	    assert_real("ss[2]", sats27[2].ss, 41.25);
+	    assert_string("gnss[0]", sats27[0].gnss, "GP");
+	    assert_boolean("used[0]", sats27[0].used, true);
+	    assert_boolean("used[1]", sats27[1].used, false);
+
+	    ix.maxtokens = 20;
+	    status = json_index(json_str22, &ix, NULL);
+	    assert_error_case(i, status, JSON_ERR_INDEXFULL);
+	    status = json_read_object_index(&ix, json_attrs_27);
+	    assert_error_case(i, status, JSON_ERR_INDEXFULL);
+	    ix.maxtokens = 32;
+	    status = json_index("{\"a\":[1,2}", &ix, NULL);
+	    assert_error_case(i, status, JSON_ERR_BADTRAIL);
+	    status = json_read_object_index(&ix, json_attrs_27);
+	    assert_error_case(i, status, JSON_ERR_INDEXFULL);
+	    status = 0;
+	}
+	break;
+
+    case 28:
+	{
+	    struct json_token_t small[6];
+	    struct json_index_t ix = {
+		.tokens = small,
+		.maxtokens = 6,
+	    };
+	    const char *end;
+
+	    status = json_tokenize(json_str23, &ix, &end);
+	    assert_error_case(i, status, JSON_ERR_INDEXFULL);
+	    assert_integer("ntokens", ix.ntokens, 6);
+	    (void)memcpy(tokens28, small, sizeof(small));
+	    ix.tokens = tokens28;
+	    ix.maxtokens = 16;
+	    status = json_tokenize(json_str23, &ix, &end);
+	    assert_case(i, status);
+	    assert_integer("ntokens", ix.ntokens, 15);
+	    assert_integer("end", *end, '\0');
+	    assert_integer("kind[9]", tokens28[9].kind, tok_string);
+	    assert_integer("len[9]", tokens28[9].end - tokens28[9].start, 5);
+	    assert(strncmp(json_str23 + tokens28[9].start, "Urgle", 5) == 0);
+	    assert_integer("parent[0]", tokens28[0].parent, -1);
+	    assert_integer("parent[6]", tokens28[6].parent, 0);
+	    assert_integer("parent[9]", tokens28[9].parent, 7);
+	    assert_integer("parent[12]", tokens28[12].parent, 6);
+	    assert_integer("next[6]", tokens28[6].next, 15);
+	    assert_integer("next[7]", tokens28[7].next, 12);
+	    assert_integer("kind[14]", tokens28[14].kind, tok_bare);
+	}
+	break;
+
+    case 29:
+	{
+	    struct json_options_t opts = {
+		.cache = &cache29,
+	    };
+	    const char *end;
+	    size_t k;
+
+	    status = json_read_object_opts(json_str29, json_attrs_24,
+					   &opts, &end);
+	    assert_case(i, status);
+	    assert_boolean("unchanged", cache29.unchanged, false);
+	    assert_integer("mode", mode24, 3);
+	    mode24 = 99;	/* a hit must not touch the targets */
+	    status = json_read_object_opts(json_str29, json_attrs_24,
+					   &opts, &end);
+	    assert_case(i, status);
+	    assert_boolean("unchanged", cache29.unchanged, true);
+	    assert_integer("mode", mode24, 99);
+	    assert_string("end", (char *)end, "{\"class\":\"TPV\",\"mode\":2}");
+	    status = json_read_object_opts(end, json_attrs_24, &opts, NULL);
+	    assert_case(i, status);
+	    assert_boolean("unchanged", cache29.unchanged, false);
+	    assert_integer("mode", mode24, 2);
+	    status = json_read_object_opts(json_str29, json_attrs_24,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    assert_boolean("unchanged", cache29.unchanged, false);
+	    assert_integer("hits", (int)cache29.hits, 1);
+	    assert_integer("misses", (int)cache29.misses, 3);
+	    /* the key is the object alone, not what follows it */
+	    status = json_read_object_opts("{\"class\":\"TPV\",\"lat\":7.5,"
+					   "\"mode\":3}\n\n", json_attrs_24,
+					   &opts, &end);
+	    assert_case(i, status);
+	    assert_boolean("unchanged", cache29.unchanged, true);
+	    assert_string("end", (char *)end, "");
+	    /* a call that bypasses the cache does not report a stale hit */
+	    opts.select = &select29;
+	    status = json_read_object_opts(json_str29, json_attrs_24,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    assert_boolean("unchanged", cache29.unchanged, false);
+	    opts.select = NULL;
+
+	    /* with text the bytes are compared, not just the hash */
+	    opts.cache = &cache29b;
+	    status = json_read_object_opts(json_str29, json_attrs_24,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    mode24 = 99;
+	    status = json_read_object_opts(json_str29, json_attrs_24,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    assert_boolean("unchanged", cache29b.unchanged, true);
+	    assert_integer("mode", mode24, 99);
+	    /* a stored copy that differs stands in for a hash collision */
+	    for (k = 0; k < sizeof(text29); k++)
+		if (text29[k] == '3')
+		    text29[k] = '4';
+	    status = json_read_object_opts(json_str29, json_attrs_24,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    assert_boolean("unchanged", cache29b.unchanged, false);
+	    assert_integer("mode", mode24, 3);
+	    /* too long for an entry's share: parsed every time */
+	    cache29b.textsize = 2 * 16;
+	    status = json_read_object_opts(json_str29, json_attrs_24,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    status = json_read_object_opts(json_str29, json_attrs_24,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    assert_boolean("unchanged", cache29b.unchanged, false);
+	    assert_integer("hits", (int)cache29b.hits, 1);
+	    assert_integer("misses", (int)cache29b.misses, 4);
+	}
+	break;
+
+    case 30:
+	{
+	    const struct {
+		const char *input;
+		const struct json_attr_t *attrs;
+		bool compiles;
+	    } runs[] = {
+		{json_str4, json_attrs_4, true},
+		{json_str8, json_attrs_8, false},	/* enumerated values */
+		{json_strOver, json_short_string, true},
+		{json_str15, json_attrs_15, false},	/* has an array */
+		{json_str24, json_attrs_24, true},
+		{json_str29, json_attrs_24, true},
+		{"{\"class\":\"SKY\",\"lat\":1}", json_attrs_24, true},
+		{"{\"lat\":\"1\"}", json_attrs_24, true},
+		{"{\"flag1\":1,\"dftint\":-4 \"flag2\":0}", json_attrs_4, true},
+		/* escaped names are decoded before matching */
+		{"{\"cl\\u0061ss\":\"TPV\",\"mo\\u0064e\":3}", json_attrs_24,
+		 true},
+		{"{\"\\u006cat\":2.5,\"\\u0061\":1}", json_attrs_24, true},
+		{"{\"cl\\u0061ss\":\"SKY\"}", json_attrs_24, true},
+		{"{\"fl\\u0061g9\":1}", json_attrs_4, true},
+	    };
+	    size_t j;
+
+	    for (j = 0; j < sizeof(runs) / sizeof(runs[0]); j++)
+		jit_agrees30(runs[j].input, runs[j].attrs, runs[j].compiles);
+	}
+	break;
+
+    case 31:
+	status = json_read_object(json_str31, json_attrs_31, NULL);
+	assert_case(i, status);
+	assert_integer("devcount", devcount31, 3);
+	assert_string("path[0]", (char *)devices31[0].path.ptr, "/dev/ttyUSB0");
+	assert_integer("len[0]", (int)devices31[0].path.len, 12);
+	assert_string("driver[0]", (char *)devices31[0].driver.ptr, "u-blox");
+	assert_integer("bps[0]", devices31[0].bps, 9600);
+	assert_string("driver[1]", (char *)devices31[1].driver.ptr, "");
+	assert_integer("dlen[1]", (int)devices31[1].driver.len, 0);
+	assert_string("path[2]", (char *)devices31[2].path.ptr,
+		      "tcp://localhost:2947/A");
+	/* exact lengths, packed one after another */
+	assert_boolean("packed", devices31[0].driver.ptr
+		       == devices31[0].path.ptr + 13, true);
+	assert_integer("used", (int)arena31.used, 13 + 7 + 10 + 23 + 1);
+	/* a second message doesn't fit until the arena is reset */
+	status = json_read_object(json_str31, json_attrs_31, NULL);
+	assert_error_case(i, status, JSON_ERR_ARENAFULL);
+	JSON_ARENA_RESET(&arena31);
+	status = json_read_object(json_str31, json_attrs_31, NULL);
+	assert_case(i, status);
+	assert_boolean("reused", devices31[0].path.ptr == store31, true);
+	break;
+
+    case 32:	/* nesting depth, which bounds the parser's stack use */
+	assert_integer("depth4", json_attr_depth(json_attrs_4), 1);
+	assert_integer("depth6", json_attr_depth(json_attrs_6), 3);
+	assert_integer("depth16", json_attr_depth(json_object_16), 3);
+	assert_integer("depth22", json_attr_depth(json_attrs_22), 3);
+	break;
+
+    case 33:
+	{
+	    struct json_options_t opts = {.maxdepth = 2};
+
+	    status = json_read_object_opts(json_str6, json_attrs_6,
+					   &opts, NULL);
+	    assert_error_case(i, status, JSON_ERR_DEPTH);
+	    status = json_read_object_opts(json_str16, json_object_16,
+					   &opts, NULL);
+	    assert_error_case(i, status, JSON_ERR_DEPTH);
+
+	    /* exactly the frames json_attr_depth() asks for */
+	    opts.frames = frames33;
+	    opts.maxdepth = json_attr_depth(json_attrs_6);
+	    dumbcount = 0;
+	    status = json_read_object_opts(json_str6, json_attrs_6,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    assert_integer("dumbcount", dumbcount, 4);
+	    assert_string("dumbstruck[3].name", dumbstruck[3].name, "Thud");
+	    assert_integer("dumbstruck[3].count", dumbstruck[3].count, 1);
+	}
+	break;
+
+    case 34:
+	status = json_read_object("{\"v\":7}", json_attrs_34, NULL);
+	assert_case(i, status);
+	assert_integer("uint34", (int)uint34, 7);
+	status = json_read_object("{\"v\":-3}", json_attrs_34, NULL);
+	assert_case(i, status);
+	assert_integer("int34", int34, -3);
+	assert_integer("uint34", (int)uint34, 0);
+	status = json_read_object("{\"v\":1e5}", json_attrs_34, NULL);
+	assert_case(i, status);
+	assert_real("real34", real34, 100000);
+	assert_integer("uint34", (int)uint34, 0);
+	status = json_read_object("{\"v\":-2.5}", json_attrs_34, NULL);
+	assert_case(i, status);
+	assert_real("real34", real34, -2.5);
+	status = json_read_object("{\"v\":true}", json_attrs_34, NULL);
+	assert_case(i, status);
+	assert_boolean("bool34", bool34, true);
+	status = json_read_object("{\"v\":\"seven\"}", json_attrs_34, NULL);
+	assert_case(i, status);
+	assert_string("str34", str34, "seven");
+	assert_integer("uint34", (int)uint34, 0);
+	break;
+
+    case 35:
+	{
+	    struct json_options_t opts = {.order = &order35};
+
+	    /* the first message only teaches the order */
+	    status = json_read_object_opts(json_str35, json_attrs_35,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    assert_integer("misses", (int)order35.misses, 4);
+	    assert_integer("hits", (int)order35.hits, 0);
+	    status = json_read_object_opts(json_str35, json_attrs_35,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    assert_integer("hits", (int)order35.hits, 4);
+	    assert_integer("mode", mode35, 3);
+	    assert_real("lon", lon35, 46.25);
+
+	    /* a different order still parses, through the fallback */
+	    status = json_read_object_opts(json_str35_shuffled, json_attrs_35,
+					   &opts, NULL);
+	    assert_case(i, status);
+	    assert_integer("mode", mode35, 1);
+	    assert_real("lat", lat35, 2);
+	    assert_real("lon", lon35, -1);
+	    assert_integer("misses", (int)order35.misses, 8);
+	}
+	break;
+
+    case 36:
+	status = json_read_object(json_str36, json_attrs_36, NULL);
+	assert_case(i, status);
+	assert_integer("long", long36, 36);
+	assert_boolean("escaped", escaped36, true);
+	/* an escaped name still has to fit the decoding buffer */
+	status = json_read_object("{\"\\u0061_key_well_over_thirty_one_"
+				  "characters\":1}", json_attrs_36, NULL);
+	assert_error_case(i, status, JSON_ERR_ATTRLEN);
+	{
+	    struct json_index_t ix = {
+		.tokens = tokens36,
+		.maxtokens = 8,
+	    };
+
+	    long36 = 0;
+	    escaped36 = false;
+	    status = json_index(json_str36, &ix, NULL);
+	    assert_case(i, status);
+	    status = json_read_object_index(&ix, json_attrs_36);
+	    assert_case(i, status);
+	    assert_integer("long", long36, 36);
+	    assert_boolean("escaped", escaped36, true);
+	}
+	break;
+
+    case 37:
+	status = json_read_object(json_str37, json_attrs_37, NULL);
+	assert_case(i, status);
+	assert_integer("nsats", nsats37, 2);
+	status = json_update_object(json_str37_update, json_attrs_37, NULL);
+	assert_case(i, status);
+	assert_integer("mode", mode37, 3);
+	assert_integer("nsats", nsats37, 3);
+	assert_boolean("sats[0].used", sats37[0].used, true);
+	/* PRN 7 was matched by key, and keeps its azimuth */
+	assert_integer("sats[1].prn", sats37[1].prn, 7);
+	assert_real("sats[1].az", sats37[1].az, 20);
+	assert_boolean("sats[1].used", sats37[1].used, true);
+	/* PRN 9 is new, so it gets the defaults */
+	assert_integer("sats[2].prn", sats37[2].prn, 9);
+	assert_real("sats[2].az", sats37[2].az, 30);
+	assert_boolean("sats[2].used", sats37[2].used, false);
+
+	status = json_update_object("{\"satellites\":[{\"az\":11}]}",
+				    json_attrs_37_byindex, NULL);
+	assert_case(i, status);
+	assert_integer("nsats", nsats37, 3);
+	assert_integer("sats[0].prn", sats37[0].prn, 5);
+	assert_real("sats[0].az", sats37[0].az, 11);
+	assert_integer("sats[2].prn", sats37[2].prn, 9);
+
+	status = json_update_object("{\"satellites\":[{\"PRN\":5}]}",
+				    json_attrs_37_badkey, NULL);
+	assert_error_case(i, status, JSON_ERR_BADATTR);
+
+	status = json_read_object("{\"devices\":[{\"name\":\"tty0\","
+				  "\"bps\":4800}]}", json_attrs_37_devs, NULL);
+	assert_case(i, status);
+	assert_string("devs[0].name", devs37[0].name, "tty");
+	status = json_update_object("{\"devices\":[{\"name\":\"tty0\","
+				    "\"bps\":9600}]}", json_attrs_37_devs, NULL);
+	assert_case(i, status);
+	assert_integer("ndevs", ndevs37, 1);
+	assert_integer("devs[0].bps", devs37[0].bps, 9600);
+
+	{
+	    struct json_attr_t levels[2];
+
+	    /* the bytes past a scalar array's member are no update key */
+	    memcpy(levels, json_attrs_37_levels, sizeof(levels));
+	    memset((char *)&levels[0].addr.array.arr.objects.key, 0x55,
+		   sizeof(levels[0].addr.array.arr.objects.key));
+	    status = json_read_object("{\"levels\":[1,2]}", levels, NULL);
+	    assert_case(i, status);
+	    status = json_update_object("{\"levels\":[7,8,9]}", levels, NULL);
+	    assert_case(i, status);
+	    assert_integer("nlevels", nlevels37, 3);
+	    assert_integer("levels[2]", levels37[2], 9);
+	    status = json_update_object("{\"levels\":[5]}", levels, NULL);
+	    assert_case(i, status);
+	    assert_integer("nlevels", nlevels37, 3);
+	    assert_integer("levels[0]", levels37[0], 5);
+	    assert_integer("levels[1]", levels37[1], 8);
+	}
+
+	/* a new key seen twice claims one element, journaled or not */
+	{
+	    struct json_journal_t journal = {.buf = journalbuf37,
+					     .size = sizeof(journalbuf37)};
+	    struct json_options_t opts = {.update = true};
+	    int j;
+
+	    for (j = 0; j < 2; j++) {
+		opts.journal = j ? &journal : NULL;
+		memset(sats37, 0, sizeof(sats37));
+		status = json_read_object(json_str37, json_attrs_37, NULL);
+		assert_case(i, status);
+		status = json_read_object_opts(json_str37_repeat,
+					       json_attrs_37, &opts, NULL);
+		assert_case(i, status);
+		assert_integer("nsats", nsats37, 4);
+		assert_integer("sats[2].prn", sats37[2].prn, 12);
+		assert_real("sats[2].az", sats37[2].az, 3);
+		assert_integer("sats[3].prn", sats37[3].prn, 11);
+		assert_real("sats[3].az", sats37[3].az, 2);
+	    }
+	    journal.used = 0;
+	    opts.journal = &journal;
+	    status = json_read_object_opts("{\"devices\":[{\"name\":\"ab\","
+					   "\"bps\":1},{\"name\":\"ab\","
+					   "\"bps\":2}]}",
+					   json_attrs_37_devs, &opts, NULL);
+	    assert_case(i, status);
+	    assert_integer("ndevs", ndevs37, 2);
+	    assert_string("devs[1].name", devs37[1].name, "ab");
+	    assert_integer("devs[1].bps", devs37[1].bps, 2);
+	}
+	break;
+
+    case 38:
+	{
+	    struct json_journal_t journal = {.buf = journalbuf38,
+					     .size = sizeof(journalbuf38)};
+	    struct json_options_t opts = {.journal = &journal};
+	    size_t needed;
+
+	    status = json_read_object_opts(json_str38, json_attrs_38, &opts,
+					   NULL);
+	    assert_case(i, status);
+	    assert_integer("mode", mode38, 3);
+	    assert_string("tag", (char *)tag38.ptr, "GPS#1");
+	    assert_integer("nsats", nsats38, 2);
+	    assert_integer("sats[1].prn", sats38[1].prn, 7);
+	    assert_integer("nlevels", nlevels38, 3);
+	    assert_integer("levels[2]", levels38[2], 3);
+	    assert_integer("arena", (int)arena38.used, 6);
+	    needed = journal.used;
+
+	    /* the bad element is last; nothing before it may stick */
+	    status = json_read_object_opts(json_str38_bad, json_attrs_38,
+					   &opts, NULL);
+	    assert_error_case(i, status, JSON_ERR_BADNUM);
+	    assert_integer("mode", mode38, 3);
+	    assert_string("tag", (char *)tag38.ptr, "GPS#1");
+	    assert_integer("nsats", nsats38, 2);
+	    assert_integer("sats[0].prn", sats38[0].prn, 5);
+	    assert_real("sats[0].az", sats38[0].az, 10);
+	    assert_integer("nlevels", nlevels38, 3);
+	    assert_integer("levels[0]", levels38[0], 1);
+	    assert_integer("arena", (int)arena38.used, 6);
+
+	    /* too small a journal fails the same way */
+	    journal.size = needed - 1;
+	    status = json_read_object_opts(json_str38, json_attrs_38, &opts,
+					   NULL);
+	    assert_error_case(i, status, JSON_ERR_JOURNALFULL);
+	    assert_integer("arena", (int)arena38.used, 6);
+	    journal.size = needed;
+	    status = json_read_object_opts(json_str38, json_attrs_38, &opts,
+					   NULL);
+	    assert_case(i, status);
+	    assert_integer("used", (int)journal.used, (int)needed);
+
+	    /* a value takes over its default's entry; headers are packed */
+	    journal.size = sizeof(journalbuf38);
+	    status = json_read_object_opts("{\"mode\":4,\"mode\":5}",
+					   json_attrs_38, &opts, NULL);
+	    assert_case(i, status);
+	    assert_integer("mode", mode38, 5);
+	    /* just the two defaults: mode's and the arena string's */
+	    assert_boolean("compact", journal.used <= 32, true);
+
+	    /* strings, array ones included, replay as they would store */
+	    (void)memset(path21, 'x', sizeof(path21));
+	    (void)memset(namestore21, 'x', sizeof(namestore21));
+	    status = json_read_object_opts("{\"path\":\"p\","
+					   "\"names\":[\"a\",1]}",
+					   json_attrs_21, &opts, NULL);
+	    assert_error_case(i, status, JSON_ERR_BADSTRING);
+	    assert_boolean("path kept", path21[0] == 'x', true);
+	    assert_boolean("names kept", namestore21[0] == 'x', true);
+	    status = json_read_object_opts(json_str21, json_attrs_21, &opts,
+					   NULL);
+	    assert_case(i, status);
+	    assert_string("path", path21, "C:\\dev/tty\"0\"\n");
+	    assert_boolean("path zeroed", path21[sizeof(path21) - 1] == '\0',
+			   true);
+	    assert_integer("namecount", namecount21, 4);
+	    assert_string("names[1]", nameptrs21[1], "tab\there");
+	    assert_string("names[2]", nameptrs21[2], "Abc");
+	    assert_string("names[3]", nameptrs21[3], "");
+	}
+	break;
+
+    case 39:
+	mode38 = 39;
+	nsats38 = -1;
+	arena38.used = 0;
+	status = json_validate_object(json_str38, strlen(json_str38),
+				      json_attrs_38);
+	assert_case(i, status);
+	/* nothing was written, not even the defaults or the arena */
+	assert_integer("mode", mode38, 39);
+	assert_integer("nsats", nsats38, -1);
+	assert_integer("arena", (int)arena38.used, 0);
+	status = json_validate_object(json_str38_bad, strlen(json_str38_bad),
+				      json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_BADNUM);
+	status = json_validate_object(json_str39_long, strlen(json_str39_long),
+				      json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_SUBTOOLONG);
+	status = json_validate_object("{\"mode\":\"3\"}", 12, json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_QNONSTRING);
+	status = json_validate_object("{\"speed\":3}", 11, json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_BADATTR);
+	/* the object has to be the whole message */
+	status = json_validate_object("{\"mode\":3} x", 12, json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_BADTRAIL);
+	status = json_validate_object("{\"mode\":3}", 8, json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_BADTRAIL);
+	/* a message cut short is refused even when NUL-terminated there */
+	status = json_validate_object("{\"mode\":3", 9, json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_BADTRAIL);
+	status = json_validate_object("{\"mode\":3,\"ta", 13, json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_BADSTRING);
+	status = json_validate_object("{\"mode\":3,\"tag\":tr", 18,
+				      json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_BADTRAIL);
+	status = json_validate_object("{\"mode\":3,\"levels\":[1,", 22,
+				      json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_BADTRAIL);
+	status = json_validate_object("  ", 2, json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_OBSTART);
+	/* a cut through a longer message is judged on the bytes given */
+	status = json_validate_object("{\"mode\":3} [1]", 10, json_attrs_38);
+	assert_case(i, status);
+	status = json_validate_object("{\"levels\":[1,2]}x", 14, json_attrs_38);
+	assert_error_case(i, status, JSON_ERR_BADTRAIL);
+	status = json_validate_object(json_dgram39.msg,
+				      sizeof(json_dgram39.msg), json_attrs_38);
+	assert_case(i, status);
+	status = json_validate_object("{\"mode\":3} \n", 12, json_attrs_38);
+	assert_case(i, status);
+	break;
+
+    case 40:
+	/* the last name callback ends the parse with its own code */
+	status = json_read_object(json_str40, json_attrs_40, NULL);
+	assert_error_case(i, status, JSON_ERR_SUBTOOLONG);
+	assert_integer("nlevels", nlevels40, 10);
+	assert_integer("levelsum", levelsum40, 55);
+	assert_integer("nsats", nsats40, 3);
+	assert_integer("prnsum", prnsum40, 21);
+	/* the PRN 7 element was given its default azimuth of -1 */
+	assert_real("azsum", azsum40, 39);
+	assert_string("names", names40, "alpha,beta,gamma");
+	{
+	    struct json_index_t ix = {
+		.tokens = tokens40,
+		.maxtokens = 40,
+	    };
+
+	    levelsum40 = prnsum40 = 0;
+	    azsum40 = 0;
+	    names40[0] = '\0';
+	    status = json_index(json_str40, &ix, NULL);
+	    assert_case(i, status);
+	    status = json_read_object_index(&ix, json_attrs_40);
+	    assert_error_case(i, status, JSON_ERR_SUBTOOLONG);
+	    assert_integer("levelsum", levelsum40, 55);
+	    assert_integer("prnsum", prnsum40, 21);
+	    assert_real("azsum", azsum40, 39);
+	    assert_string("names", names40, "alpha,beta,gamma");
+	}
+	status = json_validate_object(json_str40, strlen(json_str40),
+				      json_attrs_40);
+	assert_case(i, status);
+	break;
+
+#define MAXTEST 40
 
     default:
 	(void)fputs("Unknown test number\n", stderr);
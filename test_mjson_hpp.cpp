@@ -0,0 +1,169 @@
+/* test_mjson_hpp.cpp - unit test for the C++ bindings in mjson.hpp
+ *
+ * The schema mirrors the template in test_mjsongen.c.  Every input in
+ * test_inputs.h is read with it and with json_read_object() using the
+ * equivalent template; the return codes, end pointers and stored
+ * structures must agree.
+ *
+ * This file is Copyright (c) 2026 by the microjson contributors
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "mjson.hpp"
+#include "test_inputs.h"
+
+struct tpv {
+    char device[16];
+    int mode;
+    unsigned int sats;
+    short pdop;
+    unsigned short hdop_x10;
+    double lat, lon, alt;
+    bool used;
+    char flag;
+};
+
+/* constexpr, so the key hash is built by the compiler */
+static constexpr auto tpv_schema = mjson::schema<tpv>(
+    mjson::check("class", "TPV"),
+    mjson::field("device", &tpv::device),
+    mjson::ignore("time"),
+    mjson::field("mode", &tpv::mode, -1),
+    mjson::field("sats", &tpv::sats, 10),
+    mjson::field("pdop", &tpv::pdop),
+    mjson::field("hdop", &tpv::hdop_x10),
+    mjson::field("lat", &tpv::lat, NAN),
+    mjson::field("lon", &tpv::lon, NAN),
+    mjson::nodefault(mjson::field("alt", &tpv::alt)),
+    mjson::field("used", &tpv::used),
+    mjson::field("flag", &tpv::flag, 'x'),
+    mjson::ignore(""));
+
+static tpv interp;
+static json_attr_t json_attrs_tpv[14] = {};
+
+static void make_attrs()
+/* the C template for the schema; C++ has no nested designators */
+{
+    json_attr_t *a = json_attrs_tpv;
+
+    a->attribute = const_cast<char *>("class");
+    a->type = t_check;
+    a->dflt.check = const_cast<char *>("TPV");
+    (++a)->attribute = const_cast<char *>("device");
+    a->type = t_string;
+    a->addr.string = interp.device;
+    a->len = sizeof(interp.device);
+    (++a)->attribute = const_cast<char *>("time");
+    a->type = t_ignore;
+    (++a)->attribute = const_cast<char *>("mode");
+    a->type = t_integer;
+    a->addr.integer = &interp.mode;
+    a->dflt.integer = -1;
+    (++a)->attribute = const_cast<char *>("sats");
+    a->type = t_uinteger;
+    a->addr.uinteger = &interp.sats;
+    a->dflt.uinteger = 10;
+    (++a)->attribute = const_cast<char *>("pdop");
+    a->type = t_short;
+    a->addr.shortint = &interp.pdop;
+    (++a)->attribute = const_cast<char *>("hdop");
+    a->type = t_ushort;
+    a->addr.ushortint = &interp.hdop_x10;
+    (++a)->attribute = const_cast<char *>("lat");
+    a->type = t_real;
+    a->addr.real = &interp.lat;
+    a->dflt.real = NAN;
+    (++a)->attribute = const_cast<char *>("lon");
+    a->type = t_real;
+    a->addr.real = &interp.lon;
+    a->dflt.real = NAN;
+    (++a)->attribute = const_cast<char *>("alt");
+    a->type = t_real;
+    a->addr.real = &interp.alt;
+    a->nodefault = true;
+    (++a)->attribute = const_cast<char *>("used");
+    a->type = t_boolean;
+    a->addr.boolean = &interp.used;
+    (++a)->attribute = const_cast<char *>("flag");
+    a->type = t_character;
+    a->addr.character = &interp.flag;
+    a->dflt.character = 'x';
+    (++a)->attribute = const_cast<char *>("");
+    a->type = t_ignore;
+}
+
+static int failures;
+
+static void expect(bool ok, int i, const char *what)
+{
+    if (!ok) {
+	(void)std::fprintf(stderr, "case %d: %s wrong\n", i, what);
+	failures++;
+    }
+}
+
+int main()
+{
+    tpv fix;
+    const char *end, *iend;
+    int i, status, istatus;
+
+    make_attrs();
+    for (i = 0; i < TEST_NINPUTS; i++) {
+	/* identical starting images, so untouched bytes compare equal */
+	(void)std::memset(&fix, 0x55, sizeof(fix));
+	(void)std::memset(&interp, 0x55, sizeof(interp));
+	status = tpv_schema.read(test_inputs[i], fix, &end);
+	istatus = json_read_object(test_inputs[i], json_attrs_tpv, &iend);
+	if (status != istatus) {
+	    (void)std::fprintf(stderr, "input %d: schema %d, interpreted %d\n",
+			       i, status, istatus);
+	    failures++;
+	} else if (status == 0 && end != iend) {
+	    (void)std::fprintf(stderr, "input %d: end pointers differ\n", i);
+	    failures++;
+	} else if (status == 0 && std::memcmp(&fix, &interp, sizeof(fix)) != 0) {
+	    (void)std::fprintf(stderr, "input %d: stored values differ\n", i);
+	    failures++;
+	}
+    }
+
+    fix.alt = 123;
+    status = tpv_schema.read(test_inputs[0], fix, &end);
+    expect(status == 0 && *end == '\0', 0, "status");
+    expect(std::strcmp(fix.device, "/dev/ttyUSB0") == 0, 0, "device");
+    expect(fix.mode == 3, 0, "mode");
+    expect(fix.sats == 10, 0, "sats");
+    expect(fix.lat == 46.367303831, 0, "lat");
+    expect(fix.alt == 123, 0, "alt");
+    expect(fix.flag == 'x', 0, "flag");
+
+    status = tpv_schema.read(test_inputs[1], fix, &end);
+    expect(fix.mode == -3 && fix.sats == 7, 1, "mode/sats");
+    expect(fix.pdop == -12 && fix.hdop_x10 == 65535, 1, "pdop/hdop");
+    expect(fix.alt == 1000 && fix.used && fix.flag == 'c', 1, "alt/used/flag");
+    expect(std::isnan(fix.lat), 1, "lat default");
+
+    status = tpv_schema.read(test_inputs[2], fix, &end);
+    expect(fix.lon == 16 && fix.used && fix.lat == -0.005, 2, "values");
+    expect(std::strcmp(end, "{\"mode\":1}") == 0, 2, "end");
+
+    status = tpv_schema.read(test_inputs[3], fix, &end);
+    expect(std::strcmp(fix.device, "tab\there A\"/") == 0, 3, "device");
+
+    status = tpv_schema.read(test_inputs[4], fix, &end);
+    expect(std::strcmp(fix.device, "exactly 16 char") == 0, 4, "device");
+
+    if (failures > 0) {
+	(void)std::fprintf(stderr, "mjson.hpp test FAILED (%d)\n", failures);
+	return EXIT_FAILURE;
+    }
+    (void)std::fprintf(stderr, "mjson.hpp test succeeded.\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+/* test_mjsongen.c - check specialised parsers against the interpreter
+ *
+ * test_gen.[ch] are made by mjsongen.py from test_mjsongen.json.  Every
+ * input in test_inputs.h goes through the generated parser,
+ * json_read_object() with the equivalent template, and that template
+ * compiled by json_jit_compile(); the return codes, the end pointers
+ * and the stored structures must all agree.
+ *
+ * This file is Copyright (c) 2026 by the microjson contributors
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "mjson.h"
+#include "test_gen.h"
+#include "test_inputs.h"
+
+static struct gentpv_t interp;
+
+/* *INDENT-OFF* */
+static const struct json_attr_t json_attrs_gentpv[] = {
+    {"class",  t_check,     .dflt.check = "TPV"},
+    {"device", t_string,    .addr.string = interp.device,
+                            .len = sizeof(interp.device)},
+    {.attribute = "time", .type = t_ignore},
+    {"mode",   t_integer,   .addr.integer = &interp.mode,
+                            .dflt.integer = -1},
+    {"sats",   t_uinteger,  .addr.uinteger = &interp.sats,
+                            .dflt.uinteger = 10},
+    {"pdop",   t_short,     .addr.shortint = &interp.pdop},
+    {"hdop",   t_ushort,    .addr.ushortint = &interp.hdop_x10},
+    {"lat",    t_real,      .addr.real = &interp.lat, .dflt.real = NAN},
+    {"lon",    t_real,      .addr.real = &interp.lon, .dflt.real = NAN},
+    {"alt",    t_real,      .addr.real = &interp.alt, .nodefault = true},
+    {"used",   t_boolean,   .addr.boolean = &interp.used},
+    {"flag",   t_character, .addr.character = &interp.flag,
+                            .dflt.character = 'x'},
+    {.attribute = "", .type = t_ignore},
+    {NULL},
+};
+/* *INDENT-ON* */
+
+int main(void)
+{
+    struct gentpv_t gen, interpreted;
+    struct json_jit_t jit;
+    const char *gend, *iend, *jend;
+    int i, gst, ist, jst, failures = 0;
+
+    (void)json_jit_compile(json_attrs_gentpv, &jit);
+    for (i = 0; i < TEST_NINPUTS; i++) {
+	/* identical starting images, so untouched bytes compare equal */
+	(void)memset(&gen, 0x55, sizeof(gen));
+	(void)memset(&interp, 0x55, sizeof(interp));
+	gst = json_read_gentpv(test_inputs[i], &gen, &gend);
+	ist = json_read_object(test_inputs[i], json_attrs_gentpv, &iend);
+	if (gst != ist) {
+	    (void)fprintf(stderr, "input %d: generated %d, interpreted %d\n",
+			  i, gst, ist);
+	    failures++;
+	} else if (gst == 0 && gend != iend) {
+	    (void)fprintf(stderr, "input %d: end pointers differ\n", i);
+	    failures++;
+	} else if (gst == 0 && memcmp(&gen, &interp, sizeof(gen)) != 0) {
+	    (void)fprintf(stderr, "input %d: stored values differ\n", i);
+	    failures++;
+	}
+
+	/* the compiled template stores into interp too */
+	interpreted = interp;
+	(void)memset(&interp, 0x55, sizeof(interp));
+	jst = json_jit_read(&jit, test_inputs[i], &jend);
+	if (jst != ist) {
+	    (void)fprintf(stderr, "input %d: compiled %d, interpreted %d\n",
+			  i, jst, ist);
+	    failures++;
+	} else if (jst == 0 && jend != iend) {
+	    (void)fprintf(stderr, "input %d: compiled end pointer differs\n", i);
+	    failures++;
+	} else if (jst == 0 && memcmp(&interpreted, &interp, sizeof(interp)) != 0) {
+	    (void)fprintf(stderr, "input %d: compiled values differ\n", i);
+	    failures++;
+	}
+    }
+    json_jit_free(&jit);
+    if (failures > 0) {
+	(void)fprintf(stderr, "mjsongen test FAILED (%d)\n", failures);
+	exit(EXIT_FAILURE);
+    }
+    (void)fprintf(stderr, "mjsongen test succeeded.\n");
+    exit(EXIT_SUCCESS);
+}